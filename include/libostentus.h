@@ -7,13 +7,79 @@
 #ifndef __LIBOSTENTUS_H__
 #define __LIBOSTENTUS_H__
 #include <stdint.h>
+#include <string.h>
 #include <zephyr/device.h>
+#include <zephyr/kernel.h>
 #include <zephyr/drivers/i2c.h>
 
 struct ostentus_config {
 	struct i2c_dt_spec i2c;
 };
 
+struct ostentus_caps {
+	uint8_t version[3];
+	uint32_t caps;
+	/*
+	 * Bumped each time the driver recovers from a bus outage (see
+	 * CONFIG_OSTENTUS_RECOVERY_TIMEOUT_MS). Ostentus may have rebooted and lost its slides, text
+	 * and LEDs, so redraw when this changes.
+	 */
+	uint32_t generation;
+};
+
+enum ostentus_prio {
+	/* LEDs, display refresh and reads: served first at the next command boundary */
+	OSTENTUS_PRIO_URGENT,
+	/* Slides, text and layout */
+	OSTENTUS_PRIO_BULK,
+};
+
+struct ostentus_lane_stats {
+	uint32_t urgent_count;
+	uint32_t urgent_wait_max_us;
+	uint32_t bulk_count;
+	uint32_t bulk_wait_max_us;
+	/* Commands that gave up with -EBUSY after CONFIG_OSTENTUS_LANE_TIMEOUT_MS */
+	uint32_t timeouts;
+};
+
+#define OSTENTUS_LATENCY_BUCKETS 20
+
+struct ostentus_bus_stats {
+	uint32_t commands;
+	/* Failed transfer attempts, including ones that later succeeded on retry */
+	uint32_t errors;
+	/* Commands that returned a bus error, after any retries */
+	uint32_t failures;
+	uint32_t recoveries;
+	uint32_t recovery_max_ms;
+	/* Bucket n counts commands that took less than 2^n us; the last one also takes the rest */
+	uint32_t latency_hist[OSTENTUS_LATENCY_BUCKETS];
+};
+
+struct ostentus_lanes {
+	struct k_mutex lock;
+	struct k_condvar idle;
+	k_tid_t owner;
+	/* Nesting of the owner's sequences */
+	uint32_t depth;
+	/* Threads waiting for the lane with an urgent command; at most one per thread */
+	uint32_t urgent_waiting;
+	struct ostentus_lane_stats stats;
+};
+
+struct ostentus_data {
+	/* Negotiated at init and refreshed by ostentus_version_get() */
+	struct ostentus_caps caps;
+	struct k_spinlock caps_lock;
+	struct ostentus_lanes lanes;
+	struct k_spinlock stats_lock;
+	struct ostentus_bus_stats stats;
+	bool ready;
+	/* Thread renegotiating capabilities; its reads are never retried */
+	k_tid_t negotiator;
+};
+
 typedef int (*ostentus_cmd_t)(const struct device *dev);
 typedef int (*ostentus_getval_8_t)(const struct device *dev, uint8_t *val);
 typedef int (*ostentus_setval_8_t)(const struct device *dev, uint8_t val);
@@ -28,6 +94,12 @@ typedef int (*ostentus_write_text_t)(const struct device *dev, uint8_t x, uint8_
 typedef int (*ostentus_i2c_readbyte_t)(const struct device *dev, uint8_t reg, uint8_t *value);
 typedef int (*ostentus_i2c_readarray_t)(const struct device *dev, uint8_t reg, uint8_t *read_reg,
 					uint8_t read_len);
+typedef int (*ostentus_caps_get_t)(const struct device *dev, struct ostentus_caps *caps);
+typedef int (*ostentus_seq_begin_t)(const struct device *dev, enum ostentus_prio prio);
+typedef int (*ostentus_lane_stats_get_t)(const struct device *dev,
+					 struct ostentus_lane_stats *stats);
+typedef int (*ostentus_submit_t)(const struct device *dev, const uint8_t *cmds, size_t len);
+typedef int (*ostentus_bus_stats_get_t)(const struct device *dev, struct ostentus_bus_stats *stats);
 
 __subsystem struct ostentus_driver_api {
 	ostentus_cmd_t ostentus_clear_memory;
@@ -54,8 +126,26 @@ __subsystem struct ostentus_driver_api {
 	ostentus_write_text_t ostentus_write_text;
 	ostentus_i2c_readbyte_t ostentus_i2c_readbyte;
 	ostentus_i2c_readarray_t ostentus_i2c_readarray;
+	ostentus_caps_get_t ostentus_caps_get;
+	ostentus_seq_begin_t ostentus_seq_begin;
+	ostentus_cmd_t ostentus_seq_end;
+	ostentus_lane_stats_get_t ostentus_lane_stats_get;
+	ostentus_bus_stats_get_t ostentus_bus_stats_get;
+	ostentus_cmd_t ostentus_stats_reset;
+	ostentus_submit_t ostentus_submit;
 };
 
+/*
+ * Every command below returns 0 on success, or a negative errno:
+ *
+ * -EBUSY: the bus stayed busy for CONFIG_OSTENTUS_LANE_TIMEOUT_MS, so the command was not sent
+ * (or not sent again after a failed attempt). This happens behind another thread's long atomic
+ * sequence (see ostentus_seq_begin()), or to a bulk command (slides, text, layout) under steady
+ * urgent traffic, which is always served first. The call can simply be repeated.
+ *
+ * -EIO or another I2C error: Ostentus did not acknowledge the command, after any retries (see
+ * CONFIG_OSTENTUS_RECOVERY_TIMEOUT_MS).
+ */
 __syscall int ostentus_clear_memory(const struct device *dev);
 
 static inline int z_impl_ostentus_clear_memory(const struct device *dev)
@@ -329,6 +419,190 @@ static inline int z_impl_ostentus_i2c_readarray(const struct device *dev, uint8_
 	return api->ostentus_i2c_readarray(dev, reg, read_reg, read_len);
 }
 
+/**
+ * @brief Get the firmware version and capabilities negotiated with Ostentus
+ *
+ * The values are cached by the driver; this call does not touch the bus. Capability bits are the
+ * OSTENTUS_CAP_* values from libostentus_regmap.h.
+ *
+ * Poll @c generation to learn about recoveries. It only moves when a command was under way while
+ * Ostentus was unreachable; a reboot while the bus is idle goes unnoticed. A recovery from a
+ * burst of NACKs looks the same as one from a reboot, so redrawing must be safe either way.
+ */
+__syscall int ostentus_caps_get(const struct device *dev, struct ostentus_caps *caps);
+
+static inline int z_impl_ostentus_caps_get(const struct device *dev, struct ostentus_caps *caps)
+{
+	const struct ostentus_driver_api *api = (const struct ostentus_driver_api *)dev->api;
+	if (api->ostentus_caps_get == NULL) {
+		return -ENOSYS;
+	}
+	return api->ostentus_caps_get(dev, caps);
+}
+
+/**
+ * @brief Start an atomic command sequence
+ *
+ * Every command issued by the calling thread until ostentus_seq_end() goes out back to back at
+ * priority @p prio; commands from other threads wait for the sequence to finish. Use this around
+ * store_text/write_text pairs that must not be interleaved, e.g. drawing alarm text at
+ * OSTENTUS_PRIO_URGENT. Sequences may nest, and every successful call must be paired with
+ * ostentus_seq_end(); other threads fail with -EBUSY while a sequence is left open for longer
+ * than CONFIG_OSTENTUS_LANE_TIMEOUT_MS.
+ *
+ * @return 0 on success, -EINVAL for an unknown priority or -EBUSY if the bus stayed busy.
+ */
+__syscall int ostentus_seq_begin(const struct device *dev, enum ostentus_prio prio);
+
+static inline int z_impl_ostentus_seq_begin(const struct device *dev, enum ostentus_prio prio)
+{
+	const struct ostentus_driver_api *api = (const struct ostentus_driver_api *)dev->api;
+	if (api->ostentus_seq_begin == NULL) {
+		return -ENOSYS;
+	}
+	return api->ostentus_seq_begin(dev, prio);
+}
+
+__syscall int ostentus_seq_end(const struct device *dev);
+
+static inline int z_impl_ostentus_seq_end(const struct device *dev)
+{
+	const struct ostentus_driver_api *api = (const struct ostentus_driver_api *)dev->api;
+	if (api->ostentus_seq_end == NULL) {
+		return -ENOSYS;
+	}
+	return api->ostentus_seq_end(dev);
+}
+
+/**
+ * @brief Get the number of commands and worst-case bus wait per priority lane
+ *
+ * An urgent command waits for whatever holds the bus when it arrives, plus any urgent commands
+ * queued ahead of it. That holder is a single transfer, or a whole atomic sequence including the
+ * retries of its commands (see CONFIG_OSTENTUS_RECOVERY_TIMEOUT_MS). No command waits longer than
+ * CONFIG_OSTENTUS_LANE_TIMEOUT_MS: it then fails with -EBUSY and is counted in @c timeouts.
+ */
+__syscall int ostentus_lane_stats_get(const struct device *dev, struct ostentus_lane_stats *stats);
+
+static inline int z_impl_ostentus_lane_stats_get(const struct device *dev,
+						 struct ostentus_lane_stats *stats)
+{
+	const struct ostentus_driver_api *api = (const struct ostentus_driver_api *)dev->api;
+	if (api->ostentus_lane_stats_get == NULL) {
+		return -ENOSYS;
+	}
+	return api->ostentus_lane_stats_get(dev, stats);
+}
+
+/**
+ * @brief Get command, error, recovery and latency counters for the Ostentus bus
+ *
+ * Latency covers the whole command: lane wait, transfer and any retries.
+ */
+__syscall int ostentus_bus_stats_get(const struct device *dev, struct ostentus_bus_stats *stats);
+
+static inline int z_impl_ostentus_bus_stats_get(const struct device *dev,
+						struct ostentus_bus_stats *stats)
+{
+	const struct ostentus_driver_api *api = (const struct ostentus_driver_api *)dev->api;
+	if (api->ostentus_bus_stats_get == NULL) {
+		return -ENOSYS;
+	}
+	return api->ostentus_bus_stats_get(dev, stats);
+}
+
+/**
+ * @brief Clear both the lane and bus statistics
+ */
+__syscall int ostentus_stats_reset(const struct device *dev);
+
+static inline int z_impl_ostentus_stats_reset(const struct device *dev)
+{
+	const struct ostentus_driver_api *api = (const struct ostentus_driver_api *)dev->api;
+	if (api->ostentus_stats_reset == NULL) {
+		return -ENOSYS;
+	}
+	return api->ostentus_stats_reset(dev);
+}
+
+/**
+ * @brief Estimate a command latency percentile from the bus statistics histogram
+ *
+ * @return Upper bound in microseconds of the bucket holding percentile @p pct, or 0 if no command
+ * has been recorded.
+ */
+static inline uint32_t ostentus_latency_percentile_us(const struct ostentus_bus_stats *stats,
+						      uint8_t pct)
+{
+	uint64_t total = 0;
+	uint64_t seen = 0;
+
+	for (int i = 0; i < OSTENTUS_LATENCY_BUCKETS; i++) {
+		total += stats->latency_hist[i];
+	}
+	if (total == 0) {
+		return 0;
+	}
+
+	for (int i = 0; i < OSTENTUS_LATENCY_BUCKETS; i++) {
+		seen += stats->latency_hist[i];
+		if (seen * 100 >= total * pct) {
+			return BIT(i);
+		}
+	}
+	return BIT(OSTENTUS_LATENCY_BUCKETS - 1);
+}
+
+/**
+ * @brief Append one command to a buffer for ostentus_submit()
+ *
+ * Commands are encoded as {reg, len, payload[len]} using the OSTENTUS_* registers from
+ * libostentus_regmap.h.
+ *
+ * @return Number of bytes appended, or -ENOMEM if @p buf is too small.
+ */
+static inline int ostentus_cmd_encode(uint8_t *buf, size_t buf_len, uint8_t reg,
+				      const void *payload, uint8_t len)
+{
+	if (buf_len < 2 + (size_t)len) {
+		return -ENOMEM;
+	}
+	buf[0] = reg;
+	buf[1] = len;
+	if (len) {
+		memcpy(&buf[2], payload, len);
+	}
+	return 2 + len;
+}
+
+/**
+ * @brief Send a buffer of encoded commands in one call
+ *
+ * Lets a user mode thread redraw a whole screen with a single syscall. The buffer is checked on
+ * entry, then copied into a kernel buffer one frame (up to OSTENTUS_FRAME_LEN_LARGE bytes) at a
+ * time; only that copy is checked again and sent, so read registers, OSTENTUS_BATCH and
+ * OSTENTUS_RESET never reach the bus, even if another thread changes the buffer meanwhile. Use
+ * ostentus_reset() to reset Ostentus.
+ *
+ * Each frame takes the bus on its own and is urgent only if every command in it is, so urgent
+ * commands from other threads can go out between frames. Wrap the call in ostentus_seq_begin()
+ * and ostentus_seq_end() to send the whole buffer as one atomic sequence.
+ *
+ * @return 0 on success, -EINVAL if the buffer is malformed (nothing is sent, unless it was changed
+ * while being sent, in which case sending stops at the bad record), -EBUSY if the bus stayed busy,
+ * or the bus error of the first command that failed (later commands are not sent).
+ */
+__syscall int ostentus_submit(const struct device *dev, const uint8_t *cmds, size_t len);
+
+static inline int z_impl_ostentus_submit(const struct device *dev, const uint8_t *cmds, size_t len)
+{
+	const struct ostentus_driver_api *api = (const struct ostentus_driver_api *)dev->api;
+	if (api->ostentus_submit == NULL) {
+		return -ENOSYS;
+	}
+	return api->ostentus_submit(dev, cmds, len);
+}
+
 #include <syscalls/libostentus.h>
 
 #endif
@@ -7,6 +7,8 @@
 #ifndef __LIBOSTENTUS_REGMAP_H__
 #define __LIBOSTENTUS_REGMAP_H__
 
+#include <zephyr/sys/util_macro.h>
+
 #define LED_USE 0x01
 #define LED_GOL 0x02
 #define LED_INT 0x04
@@ -27,6 +29,8 @@
 #define OSTENTUS_SLIDE_SET     0x0B
 #define OSTENTUS_SLIDESHOW     0x0C
 #define OSTENTUS_SUMMARY_TITLE 0x0D
+#define OSTENTUS_REFRESH_PART  0x0E
+#define OSTENTUS_BATCH	       0x0F
 #define OSTENTUS_LED_USE       0x10
 #define OSTENTUS_LED_GOL       0x11
 #define OSTENTUS_LED_INT       0x12
@@ -42,9 +46,31 @@
 #define OSTENTUS_STORE_TEXT    0x26
 #define OSTENTUS_GET_VERSION   0x30
 #define OSTENTUS_FIFO_READY    0x31
+#define OSTENTUS_GET_CAPS      0x32
 #define OSTENTUS_RESET	       0x3F
 
 /* Magic number to verify reset command was intentional */
 #define OSTENTUS_RESET_MAGIC 0xA5
 
+/*
+ * OSTENTUS_GET_CAPS returns {magic, caps_lo, caps_hi}. It is only read from firmware at or above
+ * OSTENTUS_CAPS_MIN_VERSION; older firmware NACKs it and is assumed to have no capabilities.
+ */
+#define OSTENTUS_CAPS_MAGIC		0xC5
+#define OSTENTUS_CAPS_MIN_VERSION_MAJOR 2
+#define OSTENTUS_CAPS_MIN_VERSION_MINOR 0
+#define OSTENTUS_CAPS_MIN_VERSION_PATCH 0
+
+/*
+ * OSTENTUS_BATCH carries back-to-back {reg, len, payload[len]} records. A frame holds up to
+ * OSTENTUS_FRAME_LEN bytes of records, or OSTENTUS_FRAME_LEN_LARGE with OSTENTUS_CAP_LARGE_PAYLOAD.
+ */
+#define OSTENTUS_FRAME_LEN	 32
+#define OSTENTUS_FRAME_LEN_LARGE 255
+
+/* Capability bits reported by OSTENTUS_GET_CAPS */
+#define OSTENTUS_CAP_LARGE_PAYLOAD   BIT(0)
+#define OSTENTUS_CAP_MULTI_CMD	     BIT(1)
+#define OSTENTUS_CAP_PARTIAL_REFRESH BIT(2)
+
 #endif
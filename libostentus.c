@@ -17,10 +17,248 @@ LOG_MODULE_REGISTER(ostentus_driver, CONFIG_OSTENTUS_LOG_LEVEL);
 #include <libostentus.h>
 #include <libostentus_regmap.h>
 
+static enum ostentus_prio reg_prio(uint8_t reg)
+{
+	switch (reg) {
+	case OSTENTUS_REFRESH:
+	case OSTENTUS_REFRESH_PART:
+	case OSTENTUS_LED_USE:
+	case OSTENTUS_LED_GOL:
+	case OSTENTUS_LED_INT:
+	case OSTENTUS_LED_BAT:
+	case OSTENTUS_LED_POW:
+	case OSTENTUS_LED_BITMASK:
+	case OSTENTUS_GET_VERSION:
+	case OSTENTUS_FIFO_READY:
+	case OSTENTUS_GET_CAPS:
+	case OSTENTUS_RESET:
+		return OSTENTUS_PRIO_URGENT;
+	default:
+		return OSTENTUS_PRIO_BULK;
+	}
+}
+
+static int lane_acquire(const struct device *dev, enum ostentus_prio prio)
+{
+	struct ostentus_data *data = dev->data;
+	struct ostentus_lanes *lanes = &data->lanes;
+	int64_t deadline = k_uptime_get() + CONFIG_OSTENTUS_LANE_TIMEOUT_MS;
+	uint32_t start = k_cycle_get_32();
+	uint32_t wait_us;
+	int64_t remaining;
+
+	k_mutex_lock(&lanes->lock, K_FOREVER);
+
+	if (lanes->owner == k_current_get()) {
+		/* Already inside an atomic sequence on this thread */
+		lanes->depth++;
+		k_mutex_unlock(&lanes->lock);
+		return 0;
+	}
+
+	/* Bulk commands also yield to urgent ones that are waiting for the bus */
+	if (prio == OSTENTUS_PRIO_URGENT) {
+		lanes->urgent_waiting++;
+	}
+	while (lanes->owner || (prio == OSTENTUS_PRIO_BULK && lanes->urgent_waiting)) {
+		remaining = deadline - k_uptime_get();
+		if (remaining <= 0) {
+			break;
+		}
+		k_condvar_wait(&lanes->idle, &lanes->lock, K_MSEC(remaining));
+	}
+	if (prio == OSTENTUS_PRIO_URGENT) {
+		lanes->urgent_waiting--;
+	}
+
+	if (lanes->owner || (prio == OSTENTUS_PRIO_BULK && lanes->urgent_waiting)) {
+		/* A stuck owner (e.g. a sequence that was never ended) must not block us forever */
+		lanes->stats.timeouts++;
+		if (prio == OSTENTUS_PRIO_URGENT) {
+			/* Bulk waiters may have been held back only by us */
+			k_condvar_broadcast(&lanes->idle);
+		}
+		k_mutex_unlock(&lanes->lock);
+		LOG_ERR("Timed out waiting for the Ostentus bus");
+		return -EBUSY;
+	}
+
+	lanes->owner = k_current_get();
+	lanes->depth = 1;
+
+	wait_us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+	if (prio == OSTENTUS_PRIO_URGENT) {
+		lanes->stats.urgent_count++;
+		lanes->stats.urgent_wait_max_us = MAX(lanes->stats.urgent_wait_max_us, wait_us);
+		if (CONFIG_OSTENTUS_URGENT_WAIT_WARN_US &&
+		    wait_us > CONFIG_OSTENTUS_URGENT_WAIT_WARN_US) {
+			LOG_WRN("Urgent command waited %u us for the bus", wait_us);
+		}
+	} else {
+		lanes->stats.bulk_count++;
+		lanes->stats.bulk_wait_max_us = MAX(lanes->stats.bulk_wait_max_us, wait_us);
+	}
+
+	k_mutex_unlock(&lanes->lock);
+	return 0;
+}
+
+static int lane_release(const struct device *dev)
+{
+	struct ostentus_data *data = dev->data;
+	struct ostentus_lanes *lanes = &data->lanes;
+	int err = 0;
+
+	k_mutex_lock(&lanes->lock, K_FOREVER);
+
+	if (lanes->owner != k_current_get()) {
+		err = -EPERM;
+	} else if (--lanes->depth == 0) {
+		lanes->owner = NULL;
+		k_condvar_broadcast(&lanes->idle);
+	}
+
+	k_mutex_unlock(&lanes->lock);
+	return err;
+}
+
+static int caps_negotiate(const struct device *dev);
+
+static void stats_record(const struct device *dev, int err, uint32_t latency_us)
+{
+	struct ostentus_data *data = dev->data;
+	k_spinlock_key_t key;
+	/* Bucket n holds latencies below 2^n us */
+	int bucket = MIN(latency_us ? 32 - __builtin_clz(latency_us) : 0,
+			 OSTENTUS_LATENCY_BUCKETS - 1);
+
+	key = k_spin_lock(&data->stats_lock);
+	data->stats.commands++;
+	data->stats.latency_hist[bucket]++;
+	if (err) {
+		data->stats.failures++;
+	}
+	k_spin_unlock(&data->stats_lock, key);
+}
+
+/* Commands that leave Ostentus in the same state if a lost ACK makes us send them twice */
+static bool reg_retry_safe(uint8_t reg)
+{
+	switch (reg) {
+	case OSTENTUS_CLEAR_MEM:
+	case OSTENTUS_REFRESH:
+	case OSTENTUS_REFRESH_PART:
+	case OSTENTUS_SPLASHSCREEN:
+	case OSTENTUS_THICKNESS:
+	case OSTENTUS_FONT:
+	case OSTENTUS_WRITE_TEXT:
+	case OSTENTUS_CLEAR_TEXT:
+	case OSTENTUS_CLEAR_RECT:
+	case OSTENTUS_SLIDE_SET:
+	case OSTENTUS_SLIDESHOW:
+	case OSTENTUS_SUMMARY_TITLE:
+	case OSTENTUS_LED_USE:
+	case OSTENTUS_LED_GOL:
+	case OSTENTUS_LED_INT:
+	case OSTENTUS_LED_BAT:
+	case OSTENTUS_LED_POW:
+	case OSTENTUS_LED_BITMASK:
+	case OSTENTUS_GET_VERSION:
+	case OSTENTUS_FIFO_READY:
+	case OSTENTUS_GET_CAPS:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void recovery_record(const struct device *dev, uint32_t recovery_ms)
+{
+	struct ostentus_data *data = dev->data;
+	k_spinlock_key_t key = k_spin_lock(&data->stats_lock);
+
+	data->stats.recoveries++;
+	data->stats.recovery_max_ms = MAX(data->stats.recovery_max_ms, recovery_ms);
+	k_spin_unlock(&data->stats_lock, key);
+}
+
+static int bus_xfer(const struct device *dev, uint8_t reg, struct i2c_msg *msgs, uint8_t num_msgs)
+{
+	const struct ostentus_config *config = dev->config;
+	struct ostentus_data *data = dev->data;
+	/*
+	 * Don't stall boot retrying when no faceplate is fitted, and don't retry the reads of a
+	 * renegotiation, which itself runs after a recovery.
+	 */
+	bool retry = CONFIG_OSTENTUS_RECOVERY_TIMEOUT_MS > 0 && data->ready &&
+		     data->negotiator != k_current_get() && reg_retry_safe(reg);
+	uint32_t start = k_cycle_get_32();
+	uint32_t backoff_ms = 1;
+	int64_t fail_start = -1;
+	uint32_t recovery_ms;
+	k_spinlock_key_t key;
+	int err;
+
+	while (true) {
+		err = lane_acquire(dev, reg_prio(reg));
+		if (err) {
+			if (fail_start < 0) {
+				/* Never reached the bus; counted as a lane timeout instead */
+				return err;
+			}
+			break;
+		}
+		err = i2c_transfer_dt(&config->i2c, msgs, num_msgs);
+		lane_release(dev);
+
+		if (!err) {
+			break;
+		}
+
+		key = k_spin_lock(&data->stats_lock);
+		data->stats.errors++;
+		k_spin_unlock(&data->stats_lock, key);
+
+		if (!retry) {
+			break;
+		}
+		if (fail_start < 0) {
+			fail_start = k_uptime_get();
+		}
+		if (k_uptime_get() - fail_start >= CONFIG_OSTENTUS_RECOVERY_TIMEOUT_MS) {
+			LOG_ERR("Ostentus not responding: %d", err);
+			break;
+		}
+
+		/*
+		 * NACKs are expected while Ostentus reboots or is busy. The lane is released while
+		 * we back off, so urgent commands from other threads still get through, unless
+		 * this command is part of an atomic sequence.
+		 */
+		k_msleep(backoff_ms);
+		backoff_ms = MIN(backoff_ms * 2, 64);
+	}
+
+	if (!err && fail_start >= 0) {
+		recovery_ms = (uint32_t)(k_uptime_get() - fail_start);
+		recovery_record(dev, recovery_ms);
+		LOG_WRN("Ostentus recovered after %u ms", recovery_ms);
+
+		key = k_spin_lock(&data->caps_lock);
+		data->caps.generation++;
+		k_spin_unlock(&data->caps_lock, key);
+
+		/* The faceplate may have rebooted onto different firmware */
+		caps_negotiate(dev);
+	}
+
+	stats_record(dev, err, k_cyc_to_us_floor32(k_cycle_get_32() - start));
+	return err;
+}
+
 static int ostentus_i2c_write2(const struct device *dev, uint8_t reg, uint8_t *data1,
 			       uint8_t data1_len, uint8_t *data2, uint8_t data2_len)
 {
-	const struct ostentus_config *config = dev->config;
 
 	struct i2c_msg msgs[] = {
 		{
@@ -49,7 +287,7 @@ static int ostentus_i2c_write2(const struct device *dev, uint8_t reg, uint8_t *d
 		}
 	}
 
-	return i2c_transfer_dt(&config->i2c, msgs, num_msgs);
+	return bus_xfer(dev, reg, msgs, num_msgs);
 }
 
 static int ostentus_i2c_write1(const struct device *dev, uint8_t reg, uint8_t *data,
@@ -63,19 +301,27 @@ static int ostentus_i2c_write0(const struct device *dev, uint8_t reg)
 	return ostentus_i2c_write2(dev, reg, NULL, 0, NULL, 0);
 }
 
-static int i2c_readbyte(const struct device *dev, uint8_t reg, uint8_t *value)
+static int i2c_readarray(const struct device *dev, uint8_t reg, uint8_t *read_reg, uint8_t read_len)
 {
-	const struct ostentus_config *config = dev->config;
-	return i2c_write_read_dt(&config->i2c, &reg, 1, value, 1);
+	struct i2c_msg msgs[] = {
+		{
+			.buf = &reg,
+			.len = 1,
+			.flags = I2C_MSG_WRITE,
+		},
+		{
+			.buf = read_reg,
+			.len = read_len,
+			.flags = I2C_MSG_RESTART | I2C_MSG_READ | I2C_MSG_STOP,
+		},
+	};
+
+	return bus_xfer(dev, reg, msgs, ARRAY_SIZE(msgs));
 }
 
-static int i2c_readarray(const struct device *dev, uint8_t reg, uint8_t *read_reg, uint8_t read_len)
+static int i2c_readbyte(const struct device *dev, uint8_t reg, uint8_t *value)
 {
-	const struct ostentus_config *config = dev->config;
-	int err;
-	uint8_t write_reg[1] = {reg};
-	err = i2c_write_read_dt(&config->i2c, write_reg, 1, read_reg, read_len);
-	return err;
+	return i2c_readarray(dev, reg, value, 1);
 }
 
 static int clear_memory(const struct device *dev)
@@ -88,8 +334,22 @@ static int show_splash(const struct device *dev)
 	return ostentus_i2c_write0(dev, OSTENTUS_SPLASHSCREEN);
 }
 
+static bool has_cap(const struct device *dev, uint32_t cap)
+{
+	struct ostentus_data *data = dev->data;
+	k_spinlock_key_t key = k_spin_lock(&data->caps_lock);
+	bool present = (data->caps.caps & cap) == cap;
+
+	k_spin_unlock(&data->caps_lock, key);
+	return present;
+}
+
 static int update_display(const struct device *dev)
 {
+	/* Firmware with partial refresh decides on its own when a full refresh is due */
+	if (has_cap(dev, OSTENTUS_CAP_PARTIAL_REFRESH)) {
+		return ostentus_i2c_write0(dev, OSTENTUS_REFRESH_PART);
+	}
 	return ostentus_i2c_write0(dev, OSTENTUS_REFRESH);
 }
 
@@ -141,11 +401,77 @@ static int slideshow(const struct device *dev, uint32_t setting)
 				   sizeof(slideshow_delay_u.setting_buf));
 }
 
+static bool caps_register_present(const uint8_t semver[3])
+{
+	static const uint8_t min[3] = {OSTENTUS_CAPS_MIN_VERSION_MAJOR,
+				       OSTENTUS_CAPS_MIN_VERSION_MINOR,
+				       OSTENTUS_CAPS_MIN_VERSION_PATCH};
+
+	return memcmp(semver, min, sizeof(min)) >= 0;
+}
+
+static int caps_negotiate(const struct device *dev)
+{
+	struct ostentus_data *data = dev->data;
+	struct ostentus_caps caps = {0};
+	uint8_t caps_buf[3] = {0};
+	k_spinlock_key_t key;
+	int err;
+
+	err = lane_acquire(dev, OSTENTUS_PRIO_URGENT);
+	if (err) {
+		return err;
+	}
+	data->negotiator = k_current_get();
+
+	err = i2c_readarray(dev, OSTENTUS_GET_VERSION, caps.version, sizeof(caps.version));
+	if (err) {
+		goto out;
+	}
+
+	/* Only firmware that implements the capability register is asked for it */
+	if (caps_register_present(caps.version)) {
+		/* Fall back to the baseline protocol rather than failing over an optional feature */
+		int caps_err = i2c_readarray(dev, OSTENTUS_GET_CAPS, caps_buf, sizeof(caps_buf));
+
+		if (!caps_err && caps_buf[0] == OSTENTUS_CAPS_MAGIC) {
+			caps.caps = sys_get_le16(&caps_buf[1]);
+		} else {
+			LOG_WRN("Unable to read Ostentus capabilities: %d", caps_err);
+		}
+	}
+
+	/* Version and capabilities change together, before anyone else can use the bus */
+	key = k_spin_lock(&data->caps_lock);
+	caps.generation = data->caps.generation;
+	data->caps = caps;
+	k_spin_unlock(&data->caps_lock, key);
+
+out:
+	data->negotiator = NULL;
+	lane_release(dev);
+	return err;
+}
+
+static int caps_get(const struct device *dev, struct ostentus_caps *caps)
+{
+	struct ostentus_data *data = dev->data;
+	k_spinlock_key_t key = k_spin_lock(&data->caps_lock);
+	*caps = data->caps;
+	k_spin_unlock(&data->caps_lock, key);
+	return 0;
+}
+
 static int version_get(const struct device *dev, char *buf, uint8_t buf_len)
 {
-	uint8_t semver[3] = {0};
-	int err = ostentus_i2c_readarray(dev, OSTENTUS_GET_VERSION, semver, 3);
-	snprintk(buf, buf_len, "v%d.%d.%d", semver[0], semver[1], semver[2]);
+	struct ostentus_caps caps = {0};
+
+	/* Firmware may have changed since init (e.g. after a reset), so renegotiate */
+	int err = caps_negotiate(dev);
+	if (!err) {
+		caps_get(dev, &caps);
+	}
+	snprintk(buf, buf_len, "v%d.%d.%d", caps.version[0], caps.version[1], caps.version[2]);
 	return err;
 }
 
@@ -206,6 +532,216 @@ static int write_text(const struct device *dev, uint8_t x, uint8_t y, uint8_t th
 	return ostentus_i2c_write1(dev, OSTENTUS_WRITE_TEXT, data, sizeof(data));
 }
 
+static bool submit_reg_allowed(uint8_t reg)
+{
+	/* Reads, nested frames, and resets, since later records would hit a rebooting faceplate */
+	switch (reg) {
+	case OSTENTUS_RESET:
+	case OSTENTUS_BATCH:
+	case OSTENTUS_GET_VERSION:
+	case OSTENTUS_FIFO_READY:
+	case OSTENTUS_GET_CAPS:
+		return false;
+	default:
+		return true;
+	}
+}
+
+/* Length of the record at @p off, or 0 if it runs past the end of the buffer */
+static size_t submit_record_len(const uint8_t *cmds, size_t len, size_t off)
+{
+	size_t rec_len;
+
+	if (len - off < 2) {
+		return 0;
+	}
+	rec_len = 2 + cmds[off + 1];
+	return rec_len <= len - off ? rec_len : 0;
+}
+
+/* Largest OSTENTUS_BATCH frame the firmware takes, or 0 if it doesn't take any */
+static size_t submit_frame_max(const struct device *dev)
+{
+	if (!has_cap(dev, OSTENTUS_CAP_MULTI_CMD)) {
+		return 0;
+	}
+	return has_cap(dev, OSTENTUS_CAP_LARGE_PAYLOAD) ? OSTENTUS_FRAME_LEN_LARGE
+							 : OSTENTUS_FRAME_LEN;
+}
+
+static int submit_one(const struct device *dev, uint8_t reg, uint8_t *payload, uint8_t len)
+{
+	struct i2c_msg msgs[] = {
+		{
+			.buf = &reg,
+			.len = 1,
+			.flags = I2C_MSG_WRITE | (len ? 0 : I2C_MSG_STOP),
+		},
+		{
+			.buf = payload,
+			.len = len,
+			.flags = I2C_MSG_WRITE | I2C_MSG_STOP,
+		},
+	};
+
+	return bus_xfer(dev, reg, msgs, len ? 2 : 1);
+}
+
+/*
+ * Send the records packed in @p frame. The capabilities are checked again under the lane; if the
+ * firmware no longer takes a frame this size, the records go out one by one instead.
+ */
+static int submit_frame(const struct device *dev, enum ostentus_prio prio, uint8_t *frame,
+			size_t frame_len)
+{
+	uint8_t reg = OSTENTUS_BATCH;
+	struct i2c_msg msgs[] = {
+		{
+			.buf = &reg,
+			.len = 1,
+			.flags = I2C_MSG_WRITE,
+		},
+		{
+			.buf = frame,
+			.len = frame_len,
+			.flags = I2C_MSG_WRITE | I2C_MSG_STOP,
+		},
+	};
+	int err;
+
+	err = lane_acquire(dev, prio);
+	if (err) {
+		return err;
+	}
+	if (frame_len <= submit_frame_max(dev)) {
+		/* Frames are never retried, so this doesn't back off while holding the lane */
+		err = bus_xfer(dev, reg, msgs, ARRAY_SIZE(msgs));
+		lane_release(dev);
+		return err;
+	}
+	lane_release(dev);
+
+	for (size_t off = 0; off < frame_len && !err; off += 2 + frame[off + 1]) {
+		err = submit_one(dev, frame[off], &frame[off + 2], frame[off + 1]);
+	}
+	return err;
+}
+
+static int submit(const struct device *dev, const uint8_t *cmds, size_t len)
+{
+	/* Only this copy is checked and sent: the caller's buffer may change under us */
+	uint8_t frame[OSTENTUS_FRAME_LEN_LARGE];
+	enum ostentus_prio prio = OSTENTUS_PRIO_URGENT;
+	size_t frame_len = 0;
+	size_t rec_len = 0;
+	size_t off = 0;
+	uint8_t reg;
+	uint8_t payload_len;
+	int err = 0;
+
+	/* Reject a malformed buffer before anything is sent */
+	while (off < len) {
+		rec_len = submit_record_len(cmds, len, off);
+		if (!rec_len || !submit_reg_allowed(cmds[off])) {
+			return -EINVAL;
+		}
+		off += rec_len;
+	}
+
+	/*
+	 * Pack as many whole records per frame as fit; oversized ones go out on their own. Each
+	 * frame takes the lane by itself, so urgent commands from other threads get through
+	 * between frames.
+	 */
+	for (off = 0; off < len && !err; off += rec_len) {
+		if (len - off < 2) {
+			err = -EINVAL;
+			break;
+		}
+		reg = cmds[off];
+		payload_len = cmds[off + 1];
+		rec_len = 2 + payload_len;
+		if (rec_len > len - off || !submit_reg_allowed(reg)) {
+			err = -EINVAL;
+			break;
+		}
+
+		if (frame_len && frame_len + rec_len > submit_frame_max(dev)) {
+			err = submit_frame(dev, prio, frame, frame_len);
+			frame_len = 0;
+			prio = OSTENTUS_PRIO_URGENT;
+			if (err) {
+				break;
+			}
+		}
+
+		if (rec_len > submit_frame_max(dev)) {
+			memcpy(frame, &cmds[off + 2], payload_len);
+			err = submit_one(dev, reg, frame, payload_len);
+			continue;
+		}
+
+		frame[frame_len] = reg;
+		frame[frame_len + 1] = payload_len;
+		memcpy(&frame[frame_len + 2], &cmds[off + 2], payload_len);
+		frame_len += rec_len;
+		if (reg_prio(reg) == OSTENTUS_PRIO_BULK) {
+			prio = OSTENTUS_PRIO_BULK;
+		}
+	}
+
+	if (!err && frame_len) {
+		err = submit_frame(dev, prio, frame, frame_len);
+	}
+
+	return err;
+}
+
+static int seq_begin(const struct device *dev, enum ostentus_prio prio)
+{
+	if (prio != OSTENTUS_PRIO_URGENT && prio != OSTENTUS_PRIO_BULK) {
+		return -EINVAL;
+	}
+	return lane_acquire(dev, prio);
+}
+
+static int seq_end(const struct device *dev)
+{
+	return lane_release(dev);
+}
+
+static int lane_stats_get(const struct device *dev, struct ostentus_lane_stats *stats)
+{
+	struct ostentus_data *data = dev->data;
+	k_mutex_lock(&data->lanes.lock, K_FOREVER);
+	*stats = data->lanes.stats;
+	k_mutex_unlock(&data->lanes.lock);
+	return 0;
+}
+
+static int bus_stats_get(const struct device *dev, struct ostentus_bus_stats *stats)
+{
+	struct ostentus_data *data = dev->data;
+	k_spinlock_key_t key = k_spin_lock(&data->stats_lock);
+	*stats = data->stats;
+	k_spin_unlock(&data->stats_lock, key);
+	return 0;
+}
+
+static int stats_reset(const struct device *dev)
+{
+	struct ostentus_data *data = dev->data;
+	k_spinlock_key_t key;
+	k_mutex_lock(&data->lanes.lock, K_FOREVER);
+	memset(&data->lanes.stats, 0, sizeof(data->lanes.stats));
+	k_mutex_unlock(&data->lanes.lock);
+
+	key = k_spin_lock(&data->stats_lock);
+	memset(&data->stats, 0, sizeof(data->stats));
+	k_spin_unlock(&data->stats_lock, key);
+	return 0;
+}
+
 static const struct ostentus_driver_api ostentus_api = {
 	.ostentus_clear_memory = &clear_memory,
 	.ostentus_show_splash = &show_splash,
@@ -231,11 +767,88 @@ static const struct ostentus_driver_api ostentus_api = {
 	.ostentus_write_text = &write_text,
 	.ostentus_i2c_readbyte = &i2c_readbyte,
 	.ostentus_i2c_readarray = &i2c_readarray,
+	.ostentus_caps_get = &caps_get,
+	.ostentus_seq_begin = &seq_begin,
+	.ostentus_seq_end = &seq_end,
+	.ostentus_lane_stats_get = &lane_stats_get,
+	.ostentus_bus_stats_get = &bus_stats_get,
+	.ostentus_stats_reset = &stats_reset,
+	.ostentus_submit = &submit,
 };
 
+#ifdef CONFIG_USERSPACE
+#include <zephyr/internal/syscall_handler.h>
+
+/*
+ * Only the calls below are available to user mode threads; the older command calls have no
+ * verification handlers, and user mode reaches them through ostentus_submit().
+ */
+
+static inline int z_vrfy_ostentus_caps_get(const struct device *dev, struct ostentus_caps *caps)
+{
+	K_OOPS(K_SYSCALL_DRIVER_OSTENTUS(dev, ostentus_caps_get));
+	K_OOPS(K_SYSCALL_MEMORY_WRITE(caps, sizeof(*caps)));
+	return z_impl_ostentus_caps_get(dev, caps);
+}
+#include <syscalls/ostentus_caps_get_mrsh.c>
+
+static inline int z_vrfy_ostentus_seq_begin(const struct device *dev, enum ostentus_prio prio)
+{
+	/* seq_begin() rejects unknown priorities itself */
+	K_OOPS(K_SYSCALL_DRIVER_OSTENTUS(dev, ostentus_seq_begin));
+	return z_impl_ostentus_seq_begin(dev, prio);
+}
+#include <syscalls/ostentus_seq_begin_mrsh.c>
+
+static inline int z_vrfy_ostentus_seq_end(const struct device *dev)
+{
+	K_OOPS(K_SYSCALL_DRIVER_OSTENTUS(dev, ostentus_seq_end));
+	return z_impl_ostentus_seq_end(dev);
+}
+#include <syscalls/ostentus_seq_end_mrsh.c>
+
+static inline int z_vrfy_ostentus_lane_stats_get(const struct device *dev,
+						 struct ostentus_lane_stats *stats)
+{
+	K_OOPS(K_SYSCALL_DRIVER_OSTENTUS(dev, ostentus_lane_stats_get));
+	K_OOPS(K_SYSCALL_MEMORY_WRITE(stats, sizeof(*stats)));
+	return z_impl_ostentus_lane_stats_get(dev, stats);
+}
+#include <syscalls/ostentus_lane_stats_get_mrsh.c>
+
+static inline int z_vrfy_ostentus_bus_stats_get(const struct device *dev,
+						struct ostentus_bus_stats *stats)
+{
+	K_OOPS(K_SYSCALL_DRIVER_OSTENTUS(dev, ostentus_bus_stats_get));
+	K_OOPS(K_SYSCALL_MEMORY_WRITE(stats, sizeof(*stats)));
+	return z_impl_ostentus_bus_stats_get(dev, stats);
+}
+#include <syscalls/ostentus_bus_stats_get_mrsh.c>
+
+static inline int z_vrfy_ostentus_stats_reset(const struct device *dev)
+{
+	K_OOPS(K_SYSCALL_DRIVER_OSTENTUS(dev, ostentus_stats_reset));
+	return z_impl_ostentus_stats_reset(dev);
+}
+#include <syscalls/ostentus_stats_reset_mrsh.c>
+
+static inline int z_vrfy_ostentus_submit(const struct device *dev, const uint8_t *cmds, size_t len)
+{
+	/* The only check on the buffer: submit() bounds every access by len */
+	K_OOPS(K_SYSCALL_DRIVER_OSTENTUS(dev, ostentus_submit));
+	K_OOPS(K_SYSCALL_MEMORY_READ(cmds, len));
+	return z_impl_ostentus_submit(dev, cmds, len);
+}
+#include <syscalls/ostentus_submit_mrsh.c>
+#endif /* CONFIG_USERSPACE */
+
 static int ostentus_init(const struct device *dev)
 {
 	const struct ostentus_config *config = dev->config;
+	struct ostentus_data *data = dev->data;
+
+	k_mutex_init(&data->lanes.lock);
+	k_condvar_init(&data->lanes.idle);
 
 	if (!device_is_ready(config->i2c.bus)) {
 		LOG_ERR("I2C bus device not ready");
@@ -248,9 +861,11 @@ static int ostentus_init(const struct device *dev)
 		LOG_ERR("Unable to communicate with Ostentus over i2c: %d", err);
 		return err;
 	} else {
-		LOG_INF("Ostentus firmware version: %s", buf);
+		LOG_INF("Ostentus firmware version: %s, capabilities: 0x%04x", buf,
+			data->caps.caps);
 	}
 
+	data->ready = true;
 	return 0;
 }
 
@@ -259,7 +874,10 @@ static int ostentus_init(const struct device *dev)
 		.i2c = I2C_DT_SPEC_INST_GET(inst),                                                 \
 	};                                                                                         \
                                                                                                    \
-	DEVICE_DT_INST_DEFINE(inst, ostentus_init, NULL, NULL, &ostentus_config_##inst,            \
-			      POST_KERNEL, CONFIG_OSTENTUS_INIT_PRIORITY, &ostentus_api);
+	static struct ostentus_data ostentus_data_##inst;                                          \
+                                                                                                   \
+	DEVICE_DT_INST_DEFINE(inst, ostentus_init, NULL, &ostentus_data_##inst,                    \
+			      &ostentus_config_##inst, POST_KERNEL, CONFIG_OSTENTUS_INIT_PRIORITY, \
+			      &ostentus_api);
 
 DT_INST_FOREACH_STATUS_OKAY(OSTENTUS_DEFINE)
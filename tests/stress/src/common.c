@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2024 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/ztest.h>
+#include <libostentus_regmap.h>
+
+#include "common.h"
+
+const struct device *const o_dev = DEVICE_DT_GET_ONE(golioth_ostentus);
+const struct emul *const o_emul = EMUL_DT_GET(DT_INST(0, golioth_ostentus));
+
+K_THREAD_STACK_ARRAY_DEFINE(test_stacks, OSTENTUS_TEST_THREADS, 2048);
+static struct k_thread test_threads[OSTENTUS_TEST_THREADS];
+
+void ostentus_test_before(void *fixture)
+{
+	char buf[16];
+
+	ARG_UNUSED(fixture);
+
+	zassert_true(device_is_ready(o_dev), "Ostentus device not ready");
+	ostentus_emul_reset(o_emul);
+	zassert_ok(ostentus_version_get(o_dev, buf, sizeof(buf)));
+	zassert_ok(ostentus_stats_reset(o_dev));
+}
+
+int ostentus_test_firmware(uint8_t major, uint8_t minor, uint8_t patch, bool caps_present,
+			   uint16_t caps)
+{
+	char buf[16];
+	int err;
+
+	ostentus_emul_set_firmware(o_emul, major, minor, patch, caps_present, OSTENTUS_CAPS_MAGIC,
+				   caps);
+	err = ostentus_version_get(o_dev, buf, sizeof(buf));
+	ostentus_stats_reset(o_dev);
+	return err;
+}
+
+k_tid_t ostentus_test_thread_start(int idx, k_thread_entry_t entry, void *arg)
+{
+	return k_thread_create(&test_threads[idx], test_stacks[idx],
+			       K_THREAD_STACK_SIZEOF(test_stacks[idx]), entry, arg, NULL, NULL,
+			       K_PRIO_PREEMPT(1), 0, K_NO_WAIT);
+}
+
+void ostentus_test_thread_join(int idx)
+{
+	zassert_ok(k_thread_join(&test_threads[idx], K_SECONDS(10)));
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2024 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __OSTENTUS_TEST_COMMON_H__
+#define __OSTENTUS_TEST_COMMON_H__
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/kernel.h>
+#include <libostentus.h>
+
+#include "ostentus_emul.h"
+
+#define OSTENTUS_TEST_THREADS 4
+
+extern const struct device *const o_dev;
+extern const struct emul *const o_emul;
+
+/* Emulator back to defaults, driver renegotiated against it, statistics cleared */
+void ostentus_test_before(void *fixture);
+
+/* Switch the emulated firmware and make the driver renegotiate */
+int ostentus_test_firmware(uint8_t major, uint8_t minor, uint8_t patch, bool caps_present,
+			   uint16_t caps);
+
+/*
+ * Start a helper thread. It has lower priority than the (cooperative) ztest thread, so it only
+ * runs while the test thread sleeps or blocks.
+ */
+k_tid_t ostentus_test_thread_start(int idx, k_thread_entry_t entry, void *arg);
+
+void ostentus_test_thread_join(int idx);
+
+#endif
@@ -0,0 +1,453 @@
+/*
+ * Copyright (c) 2024 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define DT_DRV_COMPAT golioth_ostentus
+
+#include <string.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/i2c.h>
+#include <zephyr/drivers/i2c_emul.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <libostentus_regmap.h>
+
+#include "ostentus_emul.h"
+
+/* Time on the wire for one byte at 100 kHz, including the ACK bit */
+#define OSTENTUS_EMUL_BYTE_US 90
+
+#define OSTENTUS_EMUL_XFER_LEN 300
+
+struct ostentus_emul_data {
+	struct k_mutex lock;
+	struct ostentus_emul_state state;
+
+	uint8_t version[3];
+	bool caps_present;
+	uint8_t caps_magic;
+	uint16_t caps;
+
+	struct ostentus_emul_faults faults;
+	uint8_t nack_next;
+	bool nack_after_apply;
+	uint32_t stall_next_us;
+	int64_t down_until;
+	uint32_t rng;
+
+	ostentus_emul_text_check_t text_check;
+};
+
+static uint32_t emul_rand(struct ostentus_emul_data *data)
+{
+	/* xorshift32: deterministic so failures reproduce */
+	data->rng ^= data->rng << 13;
+	data->rng ^= data->rng >> 17;
+	data->rng ^= data->rng << 5;
+	return data->rng;
+}
+
+static bool emul_chance(struct ostentus_emul_data *data, uint16_t permille)
+{
+	return permille && (emul_rand(data) % 1000) < permille;
+}
+
+static void emul_wipe_display(struct ostentus_emul_data *data)
+{
+	data->state.leds = 0;
+	memset(data->state.slides, 0, sizeof(data->state.slides));
+	data->state.text_len = 0;
+	memset(data->state.text, 0, sizeof(data->state.text));
+	memset(data->state.drawn, 0, sizeof(data->state.drawn));
+}
+
+static void emul_reboot_locked(struct ostentus_emul_data *data, uint32_t down_ms)
+{
+	data->state.reboots++;
+	data->down_until = k_uptime_get() + down_ms;
+	emul_wipe_display(data);
+}
+
+static void emul_copy_str(char *dst, const uint8_t *src, size_t len)
+{
+	len = MIN(len, OSTENTUS_EMUL_STR_LEN - 1);
+	memcpy(dst, src, len);
+	dst[len] = '\0';
+}
+
+static int emul_apply(struct ostentus_emul_data *data, uint8_t reg, const uint8_t *p, size_t len)
+{
+	struct ostentus_emul_state *state = &data->state;
+	struct ostentus_emul_slide *slide;
+
+	switch (reg) {
+	case OSTENTUS_CLEAR_MEM:
+	case OSTENTUS_SPLASHSCREEN:
+	case OSTENTUS_THICKNESS:
+	case OSTENTUS_FONT:
+	case OSTENTUS_CLEAR_RECT:
+	case OSTENTUS_SLIDESHOW:
+	case OSTENTUS_SUMMARY_TITLE:
+		break;
+	case OSTENTUS_REFRESH:
+		state->refreshes++;
+		break;
+	case OSTENTUS_REFRESH_PART:
+		if (!(data->caps & OSTENTUS_CAP_PARTIAL_REFRESH)) {
+			return -EIO;
+		}
+		state->partial_refreshes++;
+		break;
+	case OSTENTUS_LED_USE:
+	case OSTENTUS_LED_GOL:
+	case OSTENTUS_LED_INT:
+	case OSTENTUS_LED_BAT:
+	case OSTENTUS_LED_POW:
+		if (len != 1) {
+			return -EIO;
+		}
+		WRITE_BIT(state->leds, reg - OSTENTUS_LED_USE, p[0]);
+		break;
+	case OSTENTUS_LED_BITMASK:
+		if (len != 1) {
+			return -EIO;
+		}
+		state->leds = p[0];
+		break;
+	case OSTENTUS_SLIDE_ADD:
+	case OSTENTUS_SLIDE_SET:
+		if (len < 1 || p[0] >= OSTENTUS_EMUL_SLIDES) {
+			return -EIO;
+		}
+		slide = &state->slides[p[0]];
+		if (reg == OSTENTUS_SLIDE_ADD) {
+			if (slide->used) {
+				state->slide_dup_adds++;
+			}
+			slide->used = true;
+			emul_copy_str(slide->label, &p[1], len - 1);
+		} else if (!slide->used) {
+			state->slide_unknown_sets++;
+		} else {
+			emul_copy_str(slide->value, &p[1], len - 1);
+		}
+		break;
+	case OSTENTUS_CLEAR_TEXT:
+		state->text_len = 0;
+		memset(state->text, 0, sizeof(state->text));
+		break;
+	case OSTENTUS_STORE_TEXT:
+		len = MIN(len, sizeof(state->text) - 1 - state->text_len);
+		memcpy(&state->text[state->text_len], p, len);
+		state->text_len += len;
+		break;
+	case OSTENTUS_WRITE_TEXT:
+		if (len != 3) {
+			return -EIO;
+		}
+		state->draws++;
+		if (data->text_check && !data->text_check(state->text, state->text_len)) {
+			state->torn_draws++;
+		}
+		memcpy(state->drawn, state->text, sizeof(state->drawn));
+		break;
+	default:
+		return -EIO;
+	}
+
+	if (state->log_count < OSTENTUS_EMUL_LOG_LEN) {
+		state->log[state->log_count].reg = reg;
+		state->log[state->log_count].arg = len ? p[0] : 0;
+	}
+	state->log_count++;
+
+	return 0;
+}
+
+static int emul_batch(struct ostentus_emul_data *data, const uint8_t *p, size_t len)
+{
+	size_t max = (data->caps & OSTENTUS_CAP_LARGE_PAYLOAD) ? OSTENTUS_FRAME_LEN_LARGE
+							       : OSTENTUS_FRAME_LEN;
+	size_t off = 0;
+	size_t rec_len;
+	int err;
+
+	if (!(data->caps & OSTENTUS_CAP_MULTI_CMD) || len > max) {
+		return -EIO;
+	}
+
+	if (data->state.batch_frames < OSTENTUS_EMUL_FRAMES_LEN) {
+		data->state.batch_len[data->state.batch_frames] = len;
+	}
+	data->state.batch_frames++;
+
+	while (off < len) {
+		if (len - off < 2 || 2 + p[off + 1] > len - off || p[off] == OSTENTUS_BATCH ||
+		    p[off] == OSTENTUS_RESET) {
+			return -EIO;
+		}
+		rec_len = 2 + p[off + 1];
+		err = emul_apply(data, p[off], &p[off + 2], rec_len - 2);
+		if (err) {
+			return err;
+		}
+		off += rec_len;
+	}
+
+	return 0;
+}
+
+static int emul_write(struct ostentus_emul_data *data, uint8_t reg, const uint8_t *p, size_t len)
+{
+	switch (reg) {
+	case OSTENTUS_BATCH:
+		return emul_batch(data, p, len);
+	case OSTENTUS_RESET:
+		if (len != 1 || p[0] != OSTENTUS_RESET_MAGIC) {
+			return -EIO;
+		}
+		data->state.resets++;
+		emul_reboot_locked(data, 300);
+		return 0;
+	default:
+		return emul_apply(data, reg, p, len);
+	}
+}
+
+static int emul_read(struct ostentus_emul_data *data, uint8_t reg, uint8_t *buf, size_t len)
+{
+	switch (reg) {
+	case OSTENTUS_GET_VERSION:
+		if (len != sizeof(data->version)) {
+			return -EIO;
+		}
+		memcpy(buf, data->version, sizeof(data->version));
+		return 0;
+	case OSTENTUS_GET_CAPS:
+		data->state.caps_reads++;
+		if (!data->caps_present || len != 3) {
+			return -EIO;
+		}
+		buf[0] = data->caps_magic;
+		sys_put_le16(data->caps, &buf[1]);
+		return 0;
+	case OSTENTUS_FIFO_READY:
+		if (len != 1) {
+			return -EIO;
+		}
+		buf[0] = 16;
+		return 0;
+	default:
+		return -EIO;
+	}
+}
+
+static int ostentus_emul_transfer(const struct emul *target, struct i2c_msg *msgs, int num_msgs,
+				  int addr)
+{
+	struct ostentus_emul_data *data = target->data;
+	uint8_t buf[OSTENTUS_EMUL_XFER_LEN];
+	bool read = false;
+	uint32_t wire_us;
+	size_t len = 0;
+	uint8_t reg;
+	int err;
+
+	ARG_UNUSED(addr);
+
+	if (num_msgs < 1 || (msgs[0].flags & I2C_MSG_READ) || msgs[0].len < 1 ||
+	    msgs[0].len > sizeof(buf)) {
+		return -EIO;
+	}
+	reg = msgs[0].buf[0];
+
+	/* Gather the write payload; a trailing read message makes this a register read */
+	memcpy(buf, &msgs[0].buf[1], msgs[0].len - 1);
+	len = msgs[0].len - 1;
+	for (int i = 1; i < num_msgs; i++) {
+		if (msgs[i].flags & I2C_MSG_READ) {
+			read = (i == num_msgs - 1);
+			if (!read) {
+				return -EIO;
+			}
+			break;
+		}
+		if (len + msgs[i].len > sizeof(buf)) {
+			return -EIO;
+		}
+		memcpy(&buf[len], msgs[i].buf, msgs[i].len);
+		len += msgs[i].len;
+	}
+
+	k_mutex_lock(&data->lock, K_FOREVER);
+	data->state.transfers++;
+	wire_us = (1 + len + (read ? msgs[num_msgs - 1].len : 0)) * OSTENTUS_EMUL_BYTE_US;
+	wire_us += data->stall_next_us;
+	data->stall_next_us = 0;
+	if (data->faults.stretch_max_us) {
+		wire_us += emul_rand(data) % data->faults.stretch_max_us;
+	}
+	k_mutex_unlock(&data->lock);
+
+	/* Bus time and clock stretching, without blocking fault injection from other threads */
+	k_usleep(wire_us);
+
+	k_mutex_lock(&data->lock, K_FOREVER);
+
+	if (k_uptime_get() < data->down_until) {
+		err = -EIO;
+		goto nack;
+	}
+	if ((data->nack_next && !data->nack_after_apply) ||
+	    emul_chance(data, data->faults.nack_permille)) {
+		if (data->nack_next) {
+			data->nack_next--;
+		}
+		err = -EIO;
+		goto nack;
+	}
+
+	if (read) {
+		err = emul_read(data, reg, msgs[num_msgs - 1].buf, msgs[num_msgs - 1].len);
+	} else {
+		err = emul_write(data, reg, buf, len);
+	}
+	if (err) {
+		goto nack;
+	}
+
+	/* Reads have nothing to apply twice, so only writes lose their ACK */
+	if (!read && ((data->nack_next && data->nack_after_apply) ||
+		      emul_chance(data, data->faults.ack_lost_permille))) {
+		if (data->nack_next) {
+			data->nack_next--;
+		}
+		err = -EIO;
+		goto nack;
+	}
+
+	k_mutex_unlock(&data->lock);
+	return 0;
+
+nack:
+	data->state.nacks++;
+	k_mutex_unlock(&data->lock);
+	return err;
+}
+
+void ostentus_emul_reset(const struct emul *target)
+{
+	struct ostentus_emul_data *data = target->data;
+
+	k_mutex_lock(&data->lock, K_FOREVER);
+	memset(&data->state, 0, sizeof(data->state));
+	data->version[0] = 1;
+	data->version[1] = 0;
+	data->version[2] = 0;
+	data->caps_present = false;
+	data->caps_magic = 0;
+	data->caps = 0;
+	memset(&data->faults, 0, sizeof(data->faults));
+	data->nack_next = 0;
+	data->nack_after_apply = false;
+	data->stall_next_us = 0;
+	data->down_until = 0;
+	data->rng = 0x2545F491;
+	data->text_check = NULL;
+	k_mutex_unlock(&data->lock);
+}
+
+void ostentus_emul_set_firmware(const struct emul *target, uint8_t major, uint8_t minor,
+				uint8_t patch, bool caps_present, uint8_t caps_magic, uint16_t caps)
+{
+	struct ostentus_emul_data *data = target->data;
+
+	k_mutex_lock(&data->lock, K_FOREVER);
+	data->version[0] = major;
+	data->version[1] = minor;
+	data->version[2] = patch;
+	data->caps_present = caps_present;
+	data->caps_magic = caps_magic;
+	data->caps = caps;
+	k_mutex_unlock(&data->lock);
+}
+
+void ostentus_emul_set_faults(const struct emul *target, const struct ostentus_emul_faults *faults)
+{
+	struct ostentus_emul_data *data = target->data;
+
+	k_mutex_lock(&data->lock, K_FOREVER);
+	data->faults = *faults;
+	k_mutex_unlock(&data->lock);
+}
+
+void ostentus_emul_nack_next(const struct emul *target, uint8_t count, bool after_apply)
+{
+	struct ostentus_emul_data *data = target->data;
+
+	k_mutex_lock(&data->lock, K_FOREVER);
+	data->nack_next = count;
+	data->nack_after_apply = after_apply;
+	k_mutex_unlock(&data->lock);
+}
+
+void ostentus_emul_stall_next(const struct emul *target, uint32_t us)
+{
+	struct ostentus_emul_data *data = target->data;
+
+	k_mutex_lock(&data->lock, K_FOREVER);
+	data->stall_next_us = us;
+	k_mutex_unlock(&data->lock);
+}
+
+void ostentus_emul_reboot(const struct emul *target, uint32_t down_ms)
+{
+	struct ostentus_emul_data *data = target->data;
+
+	k_mutex_lock(&data->lock, K_FOREVER);
+	emul_reboot_locked(data, down_ms);
+	k_mutex_unlock(&data->lock);
+}
+
+void ostentus_emul_set_text_check(const struct emul *target, ostentus_emul_text_check_t check)
+{
+	struct ostentus_emul_data *data = target->data;
+
+	k_mutex_lock(&data->lock, K_FOREVER);
+	data->text_check = check;
+	k_mutex_unlock(&data->lock);
+}
+
+void ostentus_emul_state_get(const struct emul *target, struct ostentus_emul_state *state)
+{
+	struct ostentus_emul_data *data = target->data;
+
+	k_mutex_lock(&data->lock, K_FOREVER);
+	*state = data->state;
+	k_mutex_unlock(&data->lock);
+}
+
+static int ostentus_emul_init(const struct emul *target, const struct device *parent)
+{
+	struct ostentus_emul_data *data = target->data;
+
+	ARG_UNUSED(parent);
+
+	k_mutex_init(&data->lock);
+	ostentus_emul_reset(target);
+	return 0;
+}
+
+static const struct i2c_emul_api ostentus_emul_api_i2c = {
+	.transfer = ostentus_emul_transfer,
+};
+
+#define OSTENTUS_EMUL_DEFINE(inst)                                                                 \
+	static struct ostentus_emul_data ostentus_emul_data_##inst;                                \
+	EMUL_DT_INST_DEFINE(inst, ostentus_emul_init, &ostentus_emul_data_##inst, NULL,            \
+			    &ostentus_emul_api_i2c, NULL);
+
+DT_INST_FOREACH_STATUS_OKAY(OSTENTUS_EMUL_DEFINE)
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2024 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __OSTENTUS_EMUL_H__
+#define __OSTENTUS_EMUL_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/drivers/emul.h>
+
+#define OSTENTUS_EMUL_SLIDES	 16
+#define OSTENTUS_EMUL_STR_LEN	 32
+#define OSTENTUS_EMUL_TEXT_LEN	 256
+#define OSTENTUS_EMUL_LOG_LEN	 64
+#define OSTENTUS_EMUL_FRAMES_LEN 8
+
+struct ostentus_emul_slide {
+	bool used;
+	char label[OSTENTUS_EMUL_STR_LEN];
+	char value[OSTENTUS_EMUL_STR_LEN];
+};
+
+/* One applied command: its register and the first payload byte (0 if none) */
+struct ostentus_emul_log {
+	uint8_t reg;
+	uint8_t arg;
+};
+
+struct ostentus_emul_state {
+	/* Display state, wiped by a reboot */
+	uint8_t leds;
+	struct ostentus_emul_slide slides[OSTENTUS_EMUL_SLIDES];
+	char text[OSTENTUS_EMUL_TEXT_LEN];
+	size_t text_len;
+	char drawn[OSTENTUS_EMUL_TEXT_LEN];
+
+	/* Counters */
+	uint32_t transfers;
+	uint32_t nacks;
+	uint32_t reboots;
+	uint32_t resets;
+	uint32_t refreshes;
+	uint32_t partial_refreshes;
+	uint32_t caps_reads;
+	uint32_t draws;
+	uint32_t torn_draws;
+	uint32_t slide_dup_adds;
+	uint32_t slide_unknown_sets;
+	uint32_t batch_frames;
+	uint32_t batch_len[OSTENTUS_EMUL_FRAMES_LEN];
+
+	/* First OSTENTUS_EMUL_LOG_LEN applied commands, in bus order */
+	struct ostentus_emul_log log[OSTENTUS_EMUL_LOG_LEN];
+	size_t log_count;
+};
+
+struct ostentus_emul_faults {
+	/* Transfers NACKed before the command is applied */
+	uint16_t nack_permille;
+	/* Transfers applied, then NACKed as if the final ACK was lost */
+	uint16_t ack_lost_permille;
+	/* Random extra clock stretching per transfer */
+	uint32_t stretch_max_us;
+};
+
+/* Return false if @p text could only come from interleaved text sequences */
+typedef bool (*ostentus_emul_text_check_t)(const char *text, size_t len);
+
+/* Back to firmware v1.0.0 without capabilities, no faults, empty display and zeroed counters */
+void ostentus_emul_reset(const struct emul *target);
+
+/* Change the firmware identity; the driver sees it after its next negotiation */
+void ostentus_emul_set_firmware(const struct emul *target, uint8_t major, uint8_t minor,
+				uint8_t patch, bool caps_present, uint8_t caps_magic,
+				uint16_t caps);
+
+void ostentus_emul_set_faults(const struct emul *target, const struct ostentus_emul_faults *faults);
+
+/* NACK the next @p count transfers, before or after applying them */
+void ostentus_emul_nack_next(const struct emul *target, uint8_t count, bool after_apply);
+
+/* Clock-stretch the next transfer by @p us */
+void ostentus_emul_stall_next(const struct emul *target, uint32_t us);
+
+/* Reboot now: display state is lost and every transfer is NACKed for @p down_ms */
+void ostentus_emul_reboot(const struct emul *target, uint32_t down_ms);
+
+void ostentus_emul_set_text_check(const struct emul *target, ostentus_emul_text_check_t check);
+
+void ostentus_emul_state_get(const struct emul *target, struct ostentus_emul_state *state);
+
+#endif
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2024 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <zephyr/ztest.h>
+#include <libostentus_regmap.h>
+
+#include "common.h"
+
+ZTEST(ostentus_caps, test_old_firmware_is_not_probed)
+{
+	static struct ostentus_emul_state state;
+	struct ostentus_caps caps;
+	char buf[16];
+
+	/* 1.x firmware would NACK the capability register, so it must not be asked */
+	ostentus_emul_set_firmware(o_emul, 1, 9, 3, true, OSTENTUS_CAPS_MAGIC,
+				   OSTENTUS_CAP_MULTI_CMD);
+	zassert_ok(ostentus_version_get(o_dev, buf, sizeof(buf)));
+	zassert_str_equal(buf, "v1.9.3");
+
+	ostentus_emul_state_get(o_emul, &state);
+	zassert_equal(state.caps_reads, 0);
+	zassert_equal(state.nacks, 0);
+
+	zassert_ok(ostentus_caps_get(o_dev, &caps));
+	zassert_equal(caps.version[0], 1);
+	zassert_equal(caps.version[1], 9);
+	zassert_equal(caps.version[2], 3);
+	zassert_equal(caps.caps, 0);
+}
+
+ZTEST(ostentus_caps, test_new_firmware_reports_caps)
+{
+	static struct ostentus_emul_state state;
+	struct ostentus_caps caps;
+
+	zassert_ok(ostentus_test_firmware(OSTENTUS_CAPS_MIN_VERSION_MAJOR,
+					  OSTENTUS_CAPS_MIN_VERSION_MINOR,
+					  OSTENTUS_CAPS_MIN_VERSION_PATCH, true,
+					  OSTENTUS_CAP_MULTI_CMD | OSTENTUS_CAP_PARTIAL_REFRESH));
+
+	ostentus_emul_state_get(o_emul, &state);
+	zassert_equal(state.caps_reads, 1);
+
+	zassert_ok(ostentus_caps_get(o_dev, &caps));
+	zassert_equal(caps.caps, OSTENTUS_CAP_MULTI_CMD | OSTENTUS_CAP_PARTIAL_REFRESH);
+}
+
+ZTEST(ostentus_caps, test_bad_magic_falls_back)
+{
+	struct ostentus_caps caps;
+	char buf[16];
+
+	ostentus_emul_set_firmware(o_emul, 2, 0, 0, true, (uint8_t)~OSTENTUS_CAPS_MAGIC,
+				   OSTENTUS_CAP_MULTI_CMD);
+	zassert_ok(ostentus_version_get(o_dev, buf, sizeof(buf)));
+	zassert_str_equal(buf, "v2.0.0");
+
+	zassert_ok(ostentus_caps_get(o_dev, &caps));
+	zassert_equal(caps.caps, 0);
+}
+
+ZTEST(ostentus_caps, test_missing_caps_register_falls_back)
+{
+	struct ostentus_caps caps;
+	char buf[16];
+
+	ostentus_emul_set_firmware(o_emul, 2, 3, 0, false, 0, 0);
+	zassert_ok(ostentus_version_get(o_dev, buf, sizeof(buf)));
+	zassert_str_equal(buf, "v2.3.0");
+
+	zassert_ok(ostentus_caps_get(o_dev, &caps));
+	zassert_equal(caps.version[1], 3);
+	zassert_equal(caps.caps, 0);
+}
+
+ZTEST(ostentus_caps, test_refresh_follows_caps)
+{
+	static struct ostentus_emul_state state;
+
+	/* Baseline firmware only knows the full refresh */
+	zassert_ok(ostentus_update_display(o_dev));
+	ostentus_emul_state_get(o_emul, &state);
+	zassert_equal(state.refreshes, 1);
+	zassert_equal(state.partial_refreshes, 0);
+
+	zassert_ok(ostentus_test_firmware(2, 0, 0, true, OSTENTUS_CAP_PARTIAL_REFRESH));
+	zassert_ok(ostentus_update_display(o_dev));
+	ostentus_emul_state_get(o_emul, &state);
+	zassert_equal(state.refreshes, 1);
+	zassert_equal(state.partial_refreshes, 1);
+
+	/* A downgrade is picked up on the next negotiation */
+	zassert_ok(ostentus_test_firmware(1, 0, 0, false, 0));
+	zassert_ok(ostentus_update_display(o_dev));
+	ostentus_emul_state_get(o_emul, &state);
+	zassert_equal(state.refreshes, 2);
+	zassert_equal(state.partial_refreshes, 1);
+}
+
+ZTEST(ostentus_caps, test_version_get_failure)
+{
+	char buf[16];
+
+	ostentus_emul_reboot(o_emul, 100);
+
+	/* Negotiation is not retried, so the error surfaces at once */
+	zassert_equal(ostentus_version_get(o_dev, buf, sizeof(buf)), -EIO);
+	zassert_str_equal(buf, "v0.0.0");
+
+	k_msleep(100);
+	zassert_ok(ostentus_version_get(o_dev, buf, sizeof(buf)));
+	zassert_str_equal(buf, "v1.0.0");
+}
+
+ZTEST_SUITE(ostentus_caps, NULL, NULL, ostentus_test_before, NULL, NULL);
@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2024 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/ztest.h>
+#include <libostentus_regmap.h>
+
+#include "common.h"
+
+static K_SEM_DEFINE(seq_release, 0, 1);
+
+static void slide_setter(void *p1, void *p2, void *p3)
+{
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	zassert_ok(ostentus_slide_set(o_dev, POINTER_TO_INT(p1), "x", 1));
+}
+
+static void led_setter(void *p1, void *p2, void *p3)
+{
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	zassert_ok(ostentus_led_bitmask(o_dev, POINTER_TO_INT(p1)));
+}
+
+static void text_drawer(void *p1, void *p2, void *p3)
+{
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	zassert_ok(ostentus_seq_begin(o_dev, OSTENTUS_PRIO_BULK));
+	zassert_ok(ostentus_clear_text_buffer(o_dev));
+	zassert_ok(ostentus_store_text(o_dev, "AB", 2));
+	/* Give the test thread time to queue an urgent command mid-sequence */
+	k_msleep(20);
+	zassert_ok(ostentus_store_text(o_dev, "CD", 2));
+	zassert_ok(ostentus_write_text(o_dev, 0, 0, 1));
+	zassert_ok(ostentus_seq_end(o_dev));
+}
+
+static void seq_holder(void *p1, void *p2, void *p3)
+{
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	zassert_ok(ostentus_seq_begin(o_dev, OSTENTUS_PRIO_BULK));
+	k_sem_take(&seq_release, K_FOREVER);
+	zassert_ok(ostentus_seq_end(o_dev));
+}
+
+static void assert_log(const struct ostentus_emul_state *state, size_t first,
+		       const struct ostentus_emul_log *expected, size_t count)
+{
+	zassert_equal(state->log_count - first, count, "%u commands applied",
+		      (unsigned int)(state->log_count - first));
+	for (size_t i = 0; i < count; i++) {
+		zassert_equal(state->log[first + i].reg, expected[i].reg,
+			      "command %u: reg 0x%02x", (unsigned int)i, state->log[first + i].reg);
+		zassert_equal(state->log[first + i].arg, expected[i].arg,
+			      "command %u: arg 0x%02x", (unsigned int)i, state->log[first + i].arg);
+	}
+}
+
+ZTEST(ostentus_lanes, test_urgent_overtakes_bulk)
+{
+	static struct ostentus_emul_state state;
+	static const struct ostentus_emul_log expected[] = {
+		{OSTENTUS_SLIDE_SET, 1},
+		{OSTENTUS_LED_BITMASK, LED_POW},
+		{OSTENTUS_SLIDE_SET, 2},
+	};
+	struct ostentus_lane_stats stats;
+	size_t first;
+
+	zassert_ok(ostentus_slide_add(o_dev, 1, "One", 3));
+	zassert_ok(ostentus_slide_add(o_dev, 2, "Two", 3));
+	zassert_ok(ostentus_stats_reset(o_dev));
+	ostentus_emul_state_get(o_emul, &state);
+	first = state.log_count;
+
+	/* Slide 1 holds the bus for 50 ms; slide 2 queues first, the LED queues after it */
+	ostentus_emul_stall_next(o_emul, 50000);
+	ostentus_test_thread_start(0, slide_setter, INT_TO_POINTER(1));
+	k_msleep(10);
+	ostentus_test_thread_start(1, slide_setter, INT_TO_POINTER(2));
+	k_msleep(10);
+	ostentus_test_thread_start(2, led_setter, INT_TO_POINTER(LED_POW));
+
+	ostentus_test_thread_join(0);
+	ostentus_test_thread_join(1);
+	ostentus_test_thread_join(2);
+
+	ostentus_emul_state_get(o_emul, &state);
+	assert_log(&state, first, expected, ARRAY_SIZE(expected));
+
+	zassert_ok(ostentus_lane_stats_get(o_dev, &stats));
+	zassert_equal(stats.urgent_count, 1);
+	zassert_equal(stats.bulk_count, 2);
+	zassert_equal(stats.timeouts, 0);
+	zassert_true(stats.urgent_wait_max_us >= 20000, "urgent waited %u us",
+		     stats.urgent_wait_max_us);
+	zassert_true(stats.bulk_wait_max_us > stats.urgent_wait_max_us,
+		     "bulk waited %u us, urgent %u us", stats.bulk_wait_max_us,
+		     stats.urgent_wait_max_us);
+}
+
+ZTEST(ostentus_lanes, test_sequence_is_atomic)
+{
+	static struct ostentus_emul_state state;
+	static const struct ostentus_emul_log expected[] = {
+		{OSTENTUS_CLEAR_TEXT, 0},
+		{OSTENTUS_STORE_TEXT, 'A'},
+		{OSTENTUS_STORE_TEXT, 'C'},
+		{OSTENTUS_WRITE_TEXT, 0},
+		{OSTENTUS_LED_BITMASK, LED_USE},
+	};
+	struct ostentus_lane_stats stats;
+
+	ostentus_test_thread_start(0, text_drawer, NULL);
+	k_msleep(10);
+
+	/* Urgent, but the sequence was already under way */
+	zassert_ok(ostentus_led_bitmask(o_dev, LED_USE));
+	ostentus_test_thread_join(0);
+
+	ostentus_emul_state_get(o_emul, &state);
+	assert_log(&state, 0, expected, ARRAY_SIZE(expected));
+	zassert_str_equal(state.drawn, "ABCD");
+
+	zassert_ok(ostentus_lane_stats_get(o_dev, &stats));
+	zassert_true(stats.urgent_wait_max_us >= 5000, "urgent waited %u us",
+		     stats.urgent_wait_max_us);
+}
+
+ZTEST(ostentus_lanes, test_sequences_nest)
+{
+	static struct ostentus_emul_state state;
+
+	zassert_equal(ostentus_seq_end(o_dev), -EPERM);
+
+	zassert_ok(ostentus_seq_begin(o_dev, OSTENTUS_PRIO_URGENT));
+	zassert_ok(ostentus_seq_begin(o_dev, OSTENTUS_PRIO_BULK));
+	zassert_ok(ostentus_led_bitmask(o_dev, LED_GOL));
+	zassert_ok(ostentus_seq_end(o_dev));
+	zassert_ok(ostentus_led_bitmask(o_dev, LED_INT));
+	zassert_ok(ostentus_seq_end(o_dev));
+	zassert_equal(ostentus_seq_end(o_dev), -EPERM);
+
+	ostentus_emul_state_get(o_emul, &state);
+	zassert_equal(state.leds, LED_INT);
+}
+
+ZTEST(ostentus_lanes, test_invalid_prio)
+{
+	zassert_equal(ostentus_seq_begin(o_dev, (enum ostentus_prio)5), -EINVAL);
+	zassert_equal(ostentus_seq_end(o_dev), -EPERM);
+}
+
+ZTEST(ostentus_lanes, test_abandoned_sequence_times_out)
+{
+	struct ostentus_lane_stats lane_stats;
+	struct ostentus_bus_stats bus_stats;
+	int64_t start;
+
+	k_sem_reset(&seq_release);
+	ostentus_test_thread_start(0, seq_holder, NULL);
+	k_msleep(10);
+
+	start = k_uptime_get();
+	zassert_equal(ostentus_led_bitmask(o_dev, LED_BAT), -EBUSY);
+	zassert_true(k_uptime_get() - start >= CONFIG_OSTENTUS_LANE_TIMEOUT_MS);
+
+	zassert_ok(ostentus_lane_stats_get(o_dev, &lane_stats));
+	zassert_equal(lane_stats.timeouts, 1);
+
+	/* The command never reached the bus */
+	zassert_ok(ostentus_bus_stats_get(o_dev, &bus_stats));
+	zassert_equal(bus_stats.commands, 0);
+	zassert_equal(bus_stats.errors, 0);
+
+	k_sem_give(&seq_release);
+	ostentus_test_thread_join(0);
+	zassert_ok(ostentus_led_bitmask(o_dev, LED_BAT));
+}
+
+ZTEST_SUITE(ostentus_lanes, NULL, NULL, ostentus_test_before, NULL, NULL);
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2024 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/ztest.h>
+#include <libostentus_regmap.h>
+
+#include "common.h"
+
+ZTEST(ostentus_recovery, test_repeatable_command_is_retried)
+{
+	static struct ostentus_emul_state state;
+	struct ostentus_bus_stats stats;
+
+	ostentus_emul_nack_next(o_emul, 2, false);
+	zassert_ok(ostentus_led_bitmask(o_dev, LED_USE | LED_POW));
+
+	ostentus_emul_state_get(o_emul, &state);
+	zassert_equal(state.leds, LED_USE | LED_POW);
+
+	zassert_ok(ostentus_bus_stats_get(o_dev, &stats));
+	zassert_equal(stats.errors, 2);
+	zassert_equal(stats.failures, 0);
+	zassert_equal(stats.recoveries, 1);
+}
+
+ZTEST(ostentus_recovery, test_slide_add_is_not_repeated)
+{
+	static struct ostentus_emul_state state;
+	struct ostentus_bus_stats stats;
+
+	/* The slide lands but its ACK is lost: sending it again would add it twice */
+	ostentus_emul_nack_next(o_emul, 1, true);
+	zassert_equal(ostentus_slide_add(o_dev, 1, "Temp", 4), -EIO);
+
+	ostentus_emul_state_get(o_emul, &state);
+	zassert_true(state.slides[1].used);
+	zassert_equal(state.slide_dup_adds, 0);
+
+	zassert_ok(ostentus_bus_stats_get(o_dev, &stats));
+	zassert_equal(stats.errors, 1);
+	zassert_equal(stats.failures, 1);
+	zassert_equal(stats.recoveries, 0);
+}
+
+ZTEST(ostentus_recovery, test_reset_is_not_repeated)
+{
+	static struct ostentus_emul_state state;
+	uint32_t transfers;
+
+	ostentus_emul_state_get(o_emul, &state);
+	transfers = state.transfers;
+
+	ostentus_emul_nack_next(o_emul, 1, false);
+	zassert_equal(ostentus_reset(o_dev), -EIO);
+
+	ostentus_emul_state_get(o_emul, &state);
+	zassert_equal(state.transfers - transfers, 1);
+	zassert_equal(state.resets, 0);
+}
+
+ZTEST(ostentus_recovery, test_gives_up_after_timeout)
+{
+	struct ostentus_bus_stats stats;
+	int64_t start;
+
+	ostentus_emul_reboot(o_emul, 2 * CONFIG_OSTENTUS_RECOVERY_TIMEOUT_MS);
+
+	start = k_uptime_get();
+	zassert_equal(ostentus_led_bitmask(o_dev, LED_POW), -EIO);
+	zassert_true(k_uptime_get() - start >= CONFIG_OSTENTUS_RECOVERY_TIMEOUT_MS);
+
+	zassert_ok(ostentus_bus_stats_get(o_dev, &stats));
+	zassert_true(stats.errors > 1);
+	zassert_equal(stats.failures, 1);
+	zassert_equal(stats.recoveries, 0);
+
+	k_msleep(CONFIG_OSTENTUS_RECOVERY_TIMEOUT_MS);
+}
+
+ZTEST(ostentus_recovery, test_rides_out_reboot_onto_new_firmware)
+{
+	static struct ostentus_emul_state state;
+	struct ostentus_bus_stats stats;
+	struct ostentus_caps caps;
+	uint32_t generation;
+
+	zassert_ok(ostentus_caps_get(o_dev, &caps));
+	generation = caps.generation;
+
+	ostentus_emul_set_firmware(o_emul, 2, 1, 0, true, OSTENTUS_CAPS_MAGIC,
+				   OSTENTUS_CAP_PARTIAL_REFRESH);
+	ostentus_emul_reboot(o_emul, 50);
+
+	zassert_ok(ostentus_led_bitmask(o_dev, LED_GOL));
+
+	zassert_ok(ostentus_bus_stats_get(o_dev, &stats));
+	zassert_equal(stats.recoveries, 1);
+	zassert_true(stats.recovery_max_ms >= 40 && stats.recovery_max_ms <= 150,
+		     "recovery took %u ms", stats.recovery_max_ms);
+
+	/* The recovery renegotiated, so the new firmware's fast paths are used */
+	zassert_ok(ostentus_caps_get(o_dev, &caps));
+	zassert_equal(caps.version[0], 2);
+	zassert_equal(caps.version[1], 1);
+	zassert_equal(caps.caps, OSTENTUS_CAP_PARTIAL_REFRESH);
+	zassert_equal(caps.generation, generation + 1, "recovery not reported");
+
+	zassert_ok(ostentus_update_display(o_dev));
+	ostentus_emul_state_get(o_emul, &state);
+	zassert_equal(state.partial_refreshes, 1);
+	zassert_equal(state.refreshes, 0);
+}
+
+ZTEST_SUITE(ostentus_recovery, NULL, NULL, ostentus_test_before, NULL, NULL);
@@ -0,0 +1,342 @@
+/*
+ * Copyright (c) 2024 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/ztest.h>
+#include <libostentus_regmap.h>
+
+#include "common.h"
+
+#define STRESS_THREADS CONFIG_OSTENTUS_STRESS_THREADS
+#define STRESS_LEDS    (LED_USE | LED_GOL | LED_INT | LED_BAT | LED_POW)
+
+/*
+ * Longest acceptable recovery: the outage itself, two backoffs at the driver's 64 ms cap for
+ * faults injected right after it, and scheduling slack
+ */
+#define STRESS_RECOVERY_MAX_MS (CONFIG_OSTENTUS_STRESS_REBOOT_MS + 2 * 64 + 50)
+
+K_THREAD_STACK_ARRAY_DEFINE(producer_stacks, STRESS_THREADS, 2048);
+static struct k_thread producer_threads[STRESS_THREADS];
+K_THREAD_STACK_DEFINE(injector_stack, 1024);
+static struct k_thread injector_thread;
+
+struct producer_stats {
+	uint32_t calls;
+	uint32_t errors;
+	/* Only latency_hist is used, so ostentus_latency_percentile_us() can read it */
+	struct ostentus_bus_stats latency;
+};
+
+static struct producer_stats producer_stats[STRESS_THREADS];
+static atomic_t stop;
+static atomic_t stop_injector;
+
+static int timed(struct producer_stats *ps, uint32_t start, int err)
+{
+	uint32_t us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+	int bucket = MIN(us ? 32 - __builtin_clz(us) : 0, OSTENTUS_LATENCY_BUCKETS - 1);
+
+	if (ps) {
+		ps->calls++;
+		ps->latency.latency_hist[bucket]++;
+		if (err) {
+			ps->errors++;
+		}
+	}
+	return err;
+}
+
+#define TIMED(ps, call) timed(ps, k_cycle_get_32(), call)
+
+static size_t skip_digits(const char *text, size_t len, size_t i)
+{
+	while (i < len && text[i] >= '0' && text[i] <= '9') {
+		i++;
+	}
+	return i;
+}
+
+/*
+ * Text drawn by a producer is a single "T<producer>:<iteration>|" store. Anything else means two
+ * text sequences were interleaved on the bus. Empty text was lost to a reboot, not interleaved.
+ */
+static bool text_whole(const char *text, size_t len)
+{
+	size_t i;
+	size_t end;
+
+	if (len == 0) {
+		return true;
+	}
+	if (text[0] != 'T') {
+		return false;
+	}
+
+	end = skip_digits(text, len, 1);
+	if (end == 1 || end >= len || text[end] != ':') {
+		return false;
+	}
+	i = end + 1;
+	end = skip_digits(text, len, i);
+	return end > i && end == len - 1 && text[end] == '|';
+}
+
+static int draw_text(struct producer_stats *ps, char *text, uint8_t y)
+{
+	int err;
+
+	err = TIMED(ps, ostentus_seq_begin(o_dev, OSTENTUS_PRIO_BULK));
+	if (err) {
+		return err;
+	}
+
+	err = TIMED(ps, ostentus_clear_text_buffer(o_dev));
+	if (!err) {
+		err = TIMED(ps, ostentus_store_text(o_dev, text, strlen(text)));
+	}
+	if (!err) {
+		err = TIMED(ps, ostentus_write_text(o_dev, 3, y, 10));
+	}
+
+	zassert_ok(ostentus_seq_end(o_dev));
+	return err;
+}
+
+static void producer(void *p1, void *p2, void *p3)
+{
+	int idx = POINTER_TO_INT(p1);
+	struct producer_stats *ps = &producer_stats[idx];
+	uint8_t id = idx + 1;
+	char msg[OSTENTUS_EMUL_STR_LEN];
+
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	/* Errors are expected under fault injection; they are counted, not fatal */
+	for (uint32_t k = 0; !atomic_get(&stop); k++) {
+		snprintk(msg, sizeof(msg), "P%d:%u", idx, k);
+		TIMED(ps, ostentus_slide_set(o_dev, id, msg, strlen(msg)));
+
+		TIMED(ps, ostentus_led_bitmask(o_dev, BIT(k % 5)));
+
+		snprintk(msg, sizeof(msg), "T%d:%u|", idx, k);
+		draw_text(ps, msg, 20 * id);
+
+		if (k % 4 == 0) {
+			TIMED(ps, ostentus_update_display(o_dev));
+		}
+	}
+}
+
+static void injector(void *p1, void *p2, void *p3)
+{
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	while (true) {
+		k_msleep(CONFIG_OSTENTUS_STRESS_REBOOT_INTERVAL_MS);
+		if (atomic_get(&stop_injector)) {
+			return;
+		}
+		ostentus_emul_reboot(o_emul, CONFIG_OSTENTUS_STRESS_REBOOT_MS);
+	}
+}
+
+struct stress_result {
+	uint32_t calls;
+	uint32_t errors;
+	uint32_t p99_call_us;
+	uint32_t p99_cmd_us;
+	uint32_t cmds_per_sec;
+	/* ostentus_caps generation when the slides were added */
+	uint32_t slides_generation;
+	struct ostentus_bus_stats bus;
+	struct ostentus_lane_stats lanes;
+};
+
+static void stress_run(bool faults, struct stress_result *res)
+{
+	struct ostentus_bus_stats calls = {0};
+	char label[OSTENTUS_EMUL_STR_LEN];
+	struct ostentus_caps caps;
+	int64_t start;
+	int64_t elapsed;
+
+	ostentus_emul_set_text_check(o_emul, text_whole);
+	for (int i = 0; i < STRESS_THREADS; i++) {
+		snprintk(label, sizeof(label), "Producer %d", i);
+		zassert_ok(ostentus_slide_add(o_dev, i + 1, label, strlen(label)));
+	}
+	zassert_ok(ostentus_caps_get(o_dev, &caps));
+
+	if (faults) {
+		struct ostentus_emul_faults f = {
+			.nack_permille = 20,
+			.ack_lost_permille = 10,
+			.stretch_max_us = 2000,
+		};
+
+		ostentus_emul_set_faults(o_emul, &f);
+	}
+
+	zassert_ok(ostentus_stats_reset(o_dev));
+	memset(producer_stats, 0, sizeof(producer_stats));
+	atomic_set(&stop, 0);
+	atomic_set(&stop_injector, 0);
+	start = k_uptime_get();
+
+	for (int i = 0; i < STRESS_THREADS; i++) {
+		k_thread_create(&producer_threads[i], producer_stacks[i],
+				K_THREAD_STACK_SIZEOF(producer_stacks[i]), producer,
+				INT_TO_POINTER(i), NULL, NULL, K_PRIO_PREEMPT(1), 0, K_NO_WAIT);
+	}
+	if (faults) {
+		k_thread_create(&injector_thread, injector_stack,
+				K_THREAD_STACK_SIZEOF(injector_stack), injector, NULL, NULL, NULL,
+				K_PRIO_PREEMPT(0), 0, K_NO_WAIT);
+	}
+
+	k_msleep(CONFIG_OSTENTUS_STRESS_DURATION_MS);
+
+	if (faults) {
+		atomic_set(&stop_injector, 1);
+		zassert_ok(k_thread_join(&injector_thread, K_SECONDS(30)));
+
+		/*
+		 * End on a reboot that the producers run into, so the final state check starts from
+		 * a wiped faceplate that the driver has reported.
+		 */
+		ostentus_emul_reboot(o_emul, CONFIG_OSTENTUS_STRESS_REBOOT_MS);
+		k_msleep(2 * CONFIG_OSTENTUS_STRESS_REBOOT_MS);
+	}
+
+	atomic_set(&stop, 1);
+	for (int i = 0; i < STRESS_THREADS; i++) {
+		zassert_ok(k_thread_join(&producer_threads[i], K_SECONDS(30)));
+	}
+	elapsed = MAX(k_uptime_get() - start, 1);
+
+	memset(res, 0, sizeof(*res));
+	res->slides_generation = caps.generation;
+	for (int i = 0; i < STRESS_THREADS; i++) {
+		res->calls += producer_stats[i].calls;
+		res->errors += producer_stats[i].errors;
+		for (int b = 0; b < OSTENTUS_LATENCY_BUCKETS; b++) {
+			calls.latency_hist[b] += producer_stats[i].latency.latency_hist[b];
+		}
+	}
+	zassert_ok(ostentus_bus_stats_get(o_dev, &res->bus));
+	zassert_ok(ostentus_lane_stats_get(o_dev, &res->lanes));
+	res->p99_call_us = ostentus_latency_percentile_us(&calls, 99);
+	res->p99_cmd_us = ostentus_latency_percentile_us(&res->bus, 99);
+	res->cmds_per_sec = (uint32_t)((uint64_t)res->bus.commands * 1000 / elapsed);
+
+	TC_PRINT("%d producers for %lld ms, faults %s\n", STRESS_THREADS, (long long)elapsed,
+		 faults ? "on" : "off");
+	TC_PRINT("  calls: %u (%u failed), bus throughput %u commands/s\n", res->calls,
+		 res->errors, res->cmds_per_sec);
+	TC_PRINT("  p99 latency: call < %u us, command < %u us\n", res->p99_call_us,
+		 res->p99_cmd_us);
+	TC_PRINT("  bus: %u errors, %u failures, %u recoveries (max %u ms)\n", res->bus.errors,
+		 res->bus.failures, res->bus.recoveries, res->bus.recovery_max_ms);
+	TC_PRINT("  lanes: urgent wait max %u us, bulk wait max %u us, %u timeouts\n",
+		 res->lanes.urgent_wait_max_us, res->lanes.bulk_wait_max_us, res->lanes.timeouts);
+}
+
+/*
+ * Quiesce, bring the display to a known state and check the faceplate really shows it. Like an
+ * application, this only learns about reboots from the driver.
+ *
+ * @return true if the driver reported a recovery and the slides were added again.
+ */
+static bool stress_verify_final_state(const struct stress_result *res)
+{
+	static struct ostentus_emul_state state;
+	struct ostentus_emul_faults none = {0};
+	char msg[OSTENTUS_EMUL_STR_LEN];
+	struct ostentus_caps caps;
+	bool redrawn;
+
+	ostentus_emul_set_faults(o_emul, &none);
+
+	zassert_ok(ostentus_caps_get(o_dev, &caps));
+	redrawn = caps.generation != res->slides_generation;
+	if (redrawn) {
+		for (int i = 0; i < STRESS_THREADS; i++) {
+			snprintk(msg, sizeof(msg), "Producer %d", i);
+			zassert_ok(ostentus_slide_add(o_dev, i + 1, msg, strlen(msg)));
+		}
+	}
+
+	for (int i = 0; i < STRESS_THREADS; i++) {
+		snprintk(msg, sizeof(msg), "F%d", i);
+		zassert_ok(ostentus_slide_set(o_dev, i + 1, msg, strlen(msg)));
+	}
+	zassert_ok(ostentus_led_bitmask(o_dev, STRESS_LEDS));
+	snprintk(msg, sizeof(msg), "T99:0|");
+	zassert_ok(draw_text(NULL, msg, 200));
+	zassert_ok(ostentus_update_display(o_dev));
+
+	ostentus_emul_state_get(o_emul, &state);
+	for (int i = 0; i < STRESS_THREADS; i++) {
+		snprintk(msg, sizeof(msg), "F%d", i);
+		zassert_true(state.slides[i + 1].used, "slide %d missing", i + 1);
+		zassert_str_equal(state.slides[i + 1].value, msg);
+	}
+	zassert_equal(state.leds, STRESS_LEDS);
+	zassert_str_equal(state.drawn, "T99:0|");
+	zassert_equal(state.torn_draws, 0, "%u text sequences were interleaved",
+		      state.torn_draws);
+	zassert_equal(state.slide_dup_adds, 0, "a slide was added twice");
+	return redrawn;
+}
+
+ZTEST(ostentus_stress, test_clean_load)
+{
+	static struct stress_result res;
+
+	stress_run(false, &res);
+
+	zassert_equal(res.errors, 0);
+	zassert_equal(res.bus.errors, 0);
+	zassert_equal(res.lanes.timeouts, 0);
+	zassert_true(res.p99_call_us <= CONFIG_OSTENTUS_STRESS_P99_MAX_US,
+		     "p99 call latency %u us over budget", res.p99_call_us);
+	zassert_true(res.cmds_per_sec >= CONFIG_OSTENTUS_STRESS_MIN_CMDS_PER_SEC,
+		     "throughput %u commands/s under budget", res.cmds_per_sec);
+
+	zassert_false(stress_verify_final_state(&res), "recovery reported without faults");
+}
+
+ZTEST(ostentus_stress, test_faulty_load)
+{
+	static struct ostentus_emul_state state;
+	static struct stress_result res;
+
+	stress_run(true, &res);
+	ostentus_emul_state_get(o_emul, &state);
+	TC_PRINT("  emulator: %u transfers, %u NACKs, %u reboots\n", state.transfers, state.nacks,
+		 state.reboots);
+
+	zassert_true(state.nacks > 0, "no faults were injected");
+	zassert_equal(res.bus.errors, state.nacks, "driver counted %u errors for %u NACKs",
+		      res.bus.errors, state.nacks);
+	zassert_true(res.bus.errors >= res.bus.failures);
+	zassert_true(res.bus.recoveries > 0, "driver never recovered from a fault");
+	zassert_true(state.reboots > 0);
+	zassert_true(res.bus.recovery_max_ms >= CONFIG_OSTENTUS_STRESS_REBOOT_MS / 2,
+		     "no recovery spanned a reboot");
+	zassert_true(res.bus.recovery_max_ms <= STRESS_RECOVERY_MAX_MS,
+		     "recovery took %u ms for a %u ms outage", res.bus.recovery_max_ms,
+		     CONFIG_OSTENTUS_STRESS_REBOOT_MS);
+
+	zassert_true(stress_verify_final_state(&res), "driver did not report the last reboot");
+}
+
+ZTEST_SUITE(ostentus_stress, NULL, NULL, ostentus_test_before, NULL, NULL);
@@ -0,0 +1,332 @@
+/*
+ * Copyright (c) 2024 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <zephyr/ztest.h>
+#include <libostentus_regmap.h>
+
+#include "common.h"
+
+/* Each LED_BITMASK record is 3 bytes on the wire */
+#define LED_REC_LEN 3
+
+static uint8_t cmds[512];
+static uint8_t text[255];
+
+static size_t encode_leds(uint8_t *buf, size_t buf_len, int count)
+{
+	size_t off = 0;
+	uint8_t mask;
+	int ret;
+
+	for (int i = 0; i < count; i++) {
+		mask = i & 0x1F;
+		ret = ostentus_cmd_encode(&buf[off], buf_len - off, OSTENTUS_LED_BITMASK, &mask, 1);
+		zassert_equal(ret, LED_REC_LEN);
+		off += ret;
+	}
+	return off;
+}
+
+static size_t encode_text(uint8_t *buf, size_t buf_len, uint8_t len)
+{
+	int ret = ostentus_cmd_encode(buf, buf_len, OSTENTUS_STORE_TEXT, text, len);
+
+	zassert_equal(ret, 2 + len);
+	return ret;
+}
+
+static void submit_and_count(size_t len, uint32_t *transfers, uint32_t *frames)
+{
+	static struct ostentus_emul_state state;
+	uint32_t transfers_before;
+	uint32_t frames_before;
+
+	ostentus_emul_state_get(o_emul, &state);
+	transfers_before = state.transfers;
+	frames_before = state.batch_frames;
+
+	zassert_ok(ostentus_submit(o_dev, cmds, len));
+
+	ostentus_emul_state_get(o_emul, &state);
+	*transfers = state.transfers - transfers_before;
+	*frames = state.batch_frames - frames_before;
+}
+
+static bool submit_atomic;
+
+static void submitter(void *p1, void *p2, void *p3)
+{
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	if (submit_atomic) {
+		zassert_ok(ostentus_seq_begin(o_dev, OSTENTUS_PRIO_BULK));
+	}
+	zassert_ok(ostentus_submit(o_dev, cmds, POINTER_TO_INT(p1)));
+	if (submit_atomic) {
+		zassert_ok(ostentus_seq_end(o_dev));
+	}
+}
+
+/* Submit three one-record frames from a helper while an urgent LED write arrives mid-way */
+static void submit_against_urgent(bool atomic, const uint8_t *expected, size_t count)
+{
+	static struct ostentus_emul_state state;
+	size_t len = 0;
+
+	zassert_ok(ostentus_test_firmware(2, 0, 0, true, OSTENTUS_CAP_MULTI_CMD));
+	for (int i = 0; i < 3; i++) {
+		len += encode_text(&cmds[len], sizeof(cmds) - len, OSTENTUS_FRAME_LEN - 2);
+	}
+
+	/* The first frame holds the bus for 50 ms */
+	submit_atomic = atomic;
+	ostentus_emul_stall_next(o_emul, 50000);
+	ostentus_test_thread_start(0, submitter, INT_TO_POINTER(len));
+	k_msleep(10);
+	zassert_ok(ostentus_led_bitmask(o_dev, LED_POW));
+	ostentus_test_thread_join(0);
+
+	ostentus_emul_state_get(o_emul, &state);
+	zassert_equal(state.batch_frames, 3);
+	zassert_equal(state.log_count, count);
+	for (size_t i = 0; i < count; i++) {
+		zassert_equal(state.log[i].reg, expected[i], "command %u: reg 0x%02x",
+			      (unsigned int)i, state.log[i].reg);
+	}
+}
+
+static void *submit_setup(void)
+{
+	memset(text, 'x', sizeof(text));
+	return NULL;
+}
+
+ZTEST(ostentus_submit, test_without_multi_cmd)
+{
+	static struct ostentus_emul_state state;
+	uint32_t transfers, frames;
+	size_t len;
+
+	len = encode_leds(cmds, sizeof(cmds), 3);
+	submit_and_count(len, &transfers, &frames);
+	zassert_equal(transfers, 3);
+	zassert_equal(frames, 0);
+
+	ostentus_emul_state_get(o_emul, &state);
+	zassert_equal(state.leds, 2);
+}
+
+ZTEST(ostentus_submit, test_packs_small_frames)
+{
+	static struct ostentus_emul_state state;
+	uint32_t transfers, frames;
+	size_t len;
+
+	zassert_ok(ostentus_test_firmware(2, 0, 0, true, OSTENTUS_CAP_MULTI_CMD));
+
+	/* 10 records fill 30 of 32 bytes; an 11th needs a second frame */
+	len = encode_leds(cmds, sizeof(cmds), 10);
+	submit_and_count(len, &transfers, &frames);
+	zassert_equal(transfers, 1);
+	zassert_equal(frames, 1);
+
+	len = encode_leds(cmds, sizeof(cmds), 11);
+	submit_and_count(len, &transfers, &frames);
+	zassert_equal(transfers, 2);
+	zassert_equal(frames, 2);
+
+	ostentus_emul_state_get(o_emul, &state);
+	zassert_equal(state.batch_len[0], 30);
+	zassert_equal(state.batch_len[1], 30);
+	zassert_equal(state.batch_len[2], 3);
+	zassert_equal(state.leds, 10);
+	zassert_equal(state.log_count, 21);
+}
+
+ZTEST(ostentus_submit, test_record_at_small_frame_limit)
+{
+	static struct ostentus_emul_state state;
+	uint32_t transfers, frames;
+	size_t len;
+
+	zassert_ok(ostentus_test_firmware(2, 0, 0, true, OSTENTUS_CAP_MULTI_CMD));
+
+	/* Exactly OSTENTUS_FRAME_LEN bytes still fits in a frame */
+	len = encode_text(cmds, sizeof(cmds), OSTENTUS_FRAME_LEN - 2);
+	submit_and_count(len, &transfers, &frames);
+	zassert_equal(transfers, 1);
+	zassert_equal(frames, 1);
+
+	/* One byte more goes out as a plain command */
+	len = encode_text(cmds, sizeof(cmds), OSTENTUS_FRAME_LEN - 1);
+	submit_and_count(len, &transfers, &frames);
+	zassert_equal(transfers, 1);
+	zassert_equal(frames, 0);
+
+	ostentus_emul_state_get(o_emul, &state);
+	zassert_equal(state.batch_len[0], OSTENTUS_FRAME_LEN);
+	zassert_equal(state.text_len, 2 * OSTENTUS_FRAME_LEN - 3);
+}
+
+ZTEST(ostentus_submit, test_oversized_record_keeps_order)
+{
+	static struct ostentus_emul_state state;
+	uint32_t transfers, frames;
+	size_t len;
+
+	zassert_ok(ostentus_test_firmware(2, 0, 0, true, OSTENTUS_CAP_MULTI_CMD));
+
+	len = encode_leds(cmds, sizeof(cmds), 2);
+	len += encode_text(&cmds[len], sizeof(cmds) - len, OSTENTUS_FRAME_LEN);
+	len += encode_leds(&cmds[len], sizeof(cmds) - len, 2);
+	submit_and_count(len, &transfers, &frames);
+	zassert_equal(transfers, 3);
+	zassert_equal(frames, 2);
+
+	ostentus_emul_state_get(o_emul, &state);
+	zassert_equal(state.batch_len[0], 2 * LED_REC_LEN);
+	zassert_equal(state.batch_len[1], 2 * LED_REC_LEN);
+	zassert_equal(state.log_count, 5);
+	zassert_equal(state.log[0].reg, OSTENTUS_LED_BITMASK);
+	zassert_equal(state.log[1].reg, OSTENTUS_LED_BITMASK);
+	zassert_equal(state.log[2].reg, OSTENTUS_STORE_TEXT);
+	zassert_equal(state.log[3].reg, OSTENTUS_LED_BITMASK);
+	zassert_equal(state.log[4].reg, OSTENTUS_LED_BITMASK);
+	zassert_equal(state.text_len, OSTENTUS_FRAME_LEN);
+}
+
+ZTEST(ostentus_submit, test_packs_large_frames)
+{
+	static struct ostentus_emul_state state;
+	uint32_t transfers, frames;
+	size_t len;
+
+	zassert_ok(ostentus_test_firmware(2, 0, 0, true,
+					  OSTENTUS_CAP_MULTI_CMD | OSTENTUS_CAP_LARGE_PAYLOAD));
+
+	/* 85 records are exactly OSTENTUS_FRAME_LEN_LARGE bytes */
+	len = encode_leds(cmds, sizeof(cmds), 85);
+	submit_and_count(len, &transfers, &frames);
+	zassert_equal(transfers, 1);
+	zassert_equal(frames, 1);
+
+	len = encode_leds(cmds, sizeof(cmds), 86);
+	submit_and_count(len, &transfers, &frames);
+	zassert_equal(transfers, 2);
+	zassert_equal(frames, 2);
+
+	ostentus_emul_state_get(o_emul, &state);
+	zassert_equal(state.batch_len[0], OSTENTUS_FRAME_LEN_LARGE);
+	zassert_equal(state.batch_len[1], OSTENTUS_FRAME_LEN_LARGE);
+	zassert_equal(state.batch_len[2], LED_REC_LEN);
+}
+
+ZTEST(ostentus_submit, test_record_at_large_frame_limit)
+{
+	static struct ostentus_emul_state state;
+	uint32_t transfers, frames;
+	size_t len;
+
+	zassert_ok(ostentus_test_firmware(2, 0, 0, true,
+					  OSTENTUS_CAP_MULTI_CMD | OSTENTUS_CAP_LARGE_PAYLOAD));
+
+	len = encode_text(cmds, sizeof(cmds), OSTENTUS_FRAME_LEN_LARGE - 2);
+	submit_and_count(len, &transfers, &frames);
+	zassert_equal(transfers, 1);
+	zassert_equal(frames, 1);
+
+	zassert_ok(ostentus_clear_text_buffer(o_dev));
+	len = encode_text(cmds, sizeof(cmds), OSTENTUS_FRAME_LEN_LARGE - 1);
+	submit_and_count(len, &transfers, &frames);
+	zassert_equal(transfers, 1);
+	zassert_equal(frames, 0);
+
+	ostentus_emul_state_get(o_emul, &state);
+	zassert_equal(state.batch_len[0], OSTENTUS_FRAME_LEN_LARGE);
+	zassert_equal(state.text_len, OSTENTUS_FRAME_LEN_LARGE - 1);
+}
+
+ZTEST(ostentus_submit, test_urgent_goes_between_frames)
+{
+	static const uint8_t expected[] = {
+		OSTENTUS_STORE_TEXT,
+		OSTENTUS_LED_BITMASK,
+		OSTENTUS_STORE_TEXT,
+		OSTENTUS_STORE_TEXT,
+	};
+
+	submit_against_urgent(false, expected, ARRAY_SIZE(expected));
+}
+
+ZTEST(ostentus_submit, test_sequence_keeps_frames_together)
+{
+	static const uint8_t expected[] = {
+		OSTENTUS_STORE_TEXT,
+		OSTENTUS_STORE_TEXT,
+		OSTENTUS_STORE_TEXT,
+		OSTENTUS_LED_BITMASK,
+	};
+
+	submit_against_urgent(true, expected, ARRAY_SIZE(expected));
+}
+
+ZTEST(ostentus_submit, test_rejects_bad_buffers)
+{
+	static struct ostentus_emul_state state;
+	static const uint8_t bad[][4] = {
+		{OSTENTUS_GET_VERSION, 0},
+		{OSTENTUS_FIFO_READY, 0},
+		{OSTENTUS_GET_CAPS, 0},
+		{OSTENTUS_BATCH, 2, OSTENTUS_REFRESH, 0},
+		{OSTENTUS_RESET, 1, OSTENTUS_RESET_MAGIC, 0},
+		/* Payload runs past the end of the buffer */
+		{OSTENTUS_LED_BITMASK, 3, 1, 0},
+	};
+	uint32_t transfers;
+	size_t len;
+
+	zassert_ok(ostentus_test_firmware(2, 0, 0, true, OSTENTUS_CAP_MULTI_CMD));
+	ostentus_emul_state_get(o_emul, &state);
+	transfers = state.transfers;
+
+	for (size_t i = 0; i < ARRAY_SIZE(bad); i++) {
+		/* A valid record first: nothing may be sent if any record is bad */
+		len = encode_leds(cmds, sizeof(cmds), 1);
+		memcpy(&cmds[len], bad[i], sizeof(bad[i]));
+		zassert_equal(ostentus_submit(o_dev, cmds, len + sizeof(bad[i])), -EINVAL,
+			      "record %u", (unsigned int)i);
+	}
+
+	/* Header cut short */
+	cmds[0] = OSTENTUS_REFRESH;
+	zassert_equal(ostentus_submit(o_dev, cmds, 1), -EINVAL);
+
+	ostentus_emul_state_get(o_emul, &state);
+	zassert_equal(state.transfers, transfers);
+}
+
+ZTEST(ostentus_submit, test_empty_buffer)
+{
+	uint32_t transfers, frames;
+
+	submit_and_count(0, &transfers, &frames);
+	zassert_equal(transfers, 0);
+}
+
+ZTEST(ostentus_submit, test_encode_bounds)
+{
+	uint8_t buf[5];
+
+	zassert_equal(ostentus_cmd_encode(buf, 4, OSTENTUS_STORE_TEXT, "abc", 3), -ENOMEM);
+	zassert_equal(ostentus_cmd_encode(buf, 1, OSTENTUS_REFRESH, NULL, 0), -ENOMEM);
+	zassert_equal(ostentus_cmd_encode(buf, sizeof(buf), OSTENTUS_STORE_TEXT, "abc", 3), 5);
+	zassert_mem_equal(buf, ((uint8_t[]){OSTENTUS_STORE_TEXT, 3, 'a', 'b', 'c'}), 5);
+	zassert_equal(ostentus_cmd_encode(buf, 2, OSTENTUS_REFRESH, NULL, 0), 2);
+}
+
+ZTEST_SUITE(ostentus_submit, NULL, submit_setup, ostentus_test_before, NULL, NULL);